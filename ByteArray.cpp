@@ -1,4 +1,5 @@
 #include "ByteArray.h"
+#include "ScratchArena.h"
 
 void ByteArray::putBytesExponent(const u_char * source, u_int size, std::vector<u_char> &destination)
 {
@@ -13,6 +14,21 @@ void ByteArray::putBytesFraction(const u_char * source, u_int size, u_int count,
         destination.push_back(source[i]);
 }
 
+void ByteArray::bytesToLimbs(const std::vector<u_char> &source, u_int64_t *destination, u_int size)
+{
+    for (u_int i = 0; i < size; ++i) destination[i] = 0;
+    for (u_int i = 0; i < source.size() && i / 8 < size; ++i)
+        destination[i / 8] |= (u_int64_t) source[source.size() - 1 - i] << (8 * (i % 8));
+}
+
+std::vector<u_char> ByteArray::limbsToBytes(const u_int64_t *source, u_int size, u_int byteCount)
+{
+    std::vector<u_char> result(byteCount, 0);
+    for (u_int i = 0; i < byteCount && i / 8 < size; ++i)
+        result[byteCount - 1 - i] = (source[i / 8] >> (8 * (i % 8))) & 0xFF;
+    return result;
+}
+
 void ByteArray::setBit(std::vector<u_char> &array, u_int position, bool value)
 {
     int bytePosition = position / 8;
@@ -35,25 +51,35 @@ bool ByteArray::getBit(std::vector<u_char> &array, u_int position)
 
 void ByteArray::shiftVectorRight(std::vector<u_char> &vector, int shift)
 {
-    int size = (unsigned) vector.size() * 8;
-    int s1 = shift;
+    int size = (int) vector.size();
+    int byteShift = shift / 8;
+    int bitShift = shift % 8;
 
-    for(int i = size - 1; i >= s1; --i)
-        setBit(vector, i, getBit(vector, i - shift));
-    for(int i = s1 - 1; i >= 0; --i)
-        setBit(vector, i, false);
+    //Move whole bytes and merge bits crossing the byte boundary (bit 0 is the highest order bit of byte 0).
+    for (int i = size - 1; i >= 0; --i)
+    {
+        int source = i - byteShift;
+        u_char byte = 0;
+        if (source >= 0) byte = (u_char) (vector[source] >> bitShift);
+        if (source >= 1 && bitShift != 0) byte |= (u_char) (vector[source - 1] << (8 - bitShift));
+        vector[i] = byte;
+    }
 }
 
-
 void ByteArray::shiftVectorLeft(std::vector<u_char> &vector, int shift)
 {
-    int size = (unsigned) vector.size() * 8;
-    int s1 = size - shift;
+    int size = (int) vector.size();
+    int byteShift = shift / 8;
+    int bitShift = shift % 8;
 
-    for (int i = 0; i < s1; ++i)
-        setBit(vector, i, getBit(vector, i + shift));
-    for (int i = s1; i < size; ++i)
-        setBit(vector, i, false);
+    for (int i = 0; i < size; ++i)
+    {
+        int source = i + byteShift;
+        u_char byte = 0;
+        if (source < size) byte = (u_char) (vector[source] << bitShift);
+        if (source + 1 < size && bitShift != 0) byte |= (u_char) (vector[source + 1] >> (8 - bitShift));
+        vector[i] = byte;
+    }
 }
 
 std::vector<u_char> ByteArray::getBytesFromInt(unsigned int value, unsigned int size)
@@ -182,38 +208,20 @@ std::vector<u_char> ByteArray::createValue(unsigned int size, u_char value)
 
 void ByteArray::multiplyBytes(std::vector<u_char> &first, const std::vector<u_char> &second)
 {
-    std::vector<std::vector<u_char>> partSums;
-
-    //Multiply first by each byte of second.
-    for (int i = second.size() - 1; i >= 0; --i)
-    {
-        std::vector<u_char> partSum = first;
-        multiplyBytesByByte(partSum, second[i]);
-        partSums.push_back(partSum);
-    }
-
-    //Calculate size of partial sums.
-    unsigned int sizeF = first.size();
-    unsigned int sizeS = second.size();
-    unsigned int size = sizeF + sizeS - 1;
-
-    //Make all part sums equal size.
-    for (unsigned int i = 0; i < partSums.size(); ++i)
-    {
-        for (unsigned int j = 0; j < i; ++j)
-            partSums[i].push_back(0);
-
-        for (unsigned int j = i; partSums[i].size() <= size; ++j)
-            partSums[i].insert(partSums[i].begin(), 0);
-    }
-
-    first = partSums[0];
-    u_char carryover = 0; //Sum of all carry occurrences.
-    for (unsigned int i = 1; i < partSums.size(); ++i)
-        if (addBytesEqualSize(first, partSums[i])) carryover++;
-
-    //If range has to be extended.
-    if (carryover > 0) first.insert(first.begin(), carryover);
+    //Multiply using the limb engine.
+    u_int firstSize = (first.size() + 7) / 8;
+    u_int secondSize = (second.size() + 7) / 8;
+    ScratchArena::Frame frame;
+    u_int64_t *firstLimbs = frame.allocate(firstSize);
+    u_int64_t *secondLimbs = frame.allocate(secondSize);
+    u_int64_t *result = frame.allocate(firstSize + secondSize);
+    bytesToLimbs(first, firstLimbs, firstSize);
+    bytesToLimbs(second, secondLimbs, secondSize);
+    LimbArray::multiplyLimbs(result, firstLimbs, firstSize, secondLimbs, secondSize);
+
+    //Range is only extended if the product does not fit in (first + second - 1) bytes.
+    first = limbsToBytes(result, firstSize + secondSize, first.size() + second.size());
+    if (first[0] == 0) first.erase(first.begin());
 }
 
 void ByteArray::multiplyBytesByByte(std::vector<u_char> &first, u_char multiplier)
@@ -355,7 +363,7 @@ std::vector<u_char> ByteArray::cutVector(std::vector<u_char> &first, unsigned in
 std::string ByteArray::toBinaryString(const std::vector<u_char> &first, unsigned int point)
 {
     std::string ret;
-    for (int i = 0; i <= first.size(); ++i)
+    for (int i = 0; i < first.size(); ++i)
     {
         u_char mask = 0x80;
         for (int j = 7; j >= 0; --j)
@@ -3,6 +3,8 @@
 #include <iostream>
 #include <vector>
 
+#include "LimbArray.h"
+
 /// Static class for variable precision byte array manipulation.
 class ByteArray
 {
@@ -23,6 +25,19 @@ public:
     /// \param destination - destination vector.
     static void putBytesExponent(const u_char * source, u_int size, std::vector<u_char> &destination);
 
+    /// Converts a big-endian byte container into a limb container holding the same unsigned value.
+    /// \param source - source byte vector.
+    /// \param destination - destination limb array (bytes that do not fit are ignored).
+    /// \param size - destination limb count.
+    static void bytesToLimbs(const std::vector<u_char> &source, u_int64_t *destination, u_int size);
+
+    /// Converts lowest order bytes of a limb container into a big-endian byte container.
+    /// \param source - source limb array.
+    /// \param size - source limb count.
+    /// \param byteCount - number of bytes to be created.
+    /// \return Vector of bytes holding 'byteCount' lowest order bytes of 'source'.
+    static std::vector<u_char> limbsToBytes(const u_int64_t *source, u_int size, u_int byteCount);
+
     /// Sets specified bit value.
     /// \param array - byte array which single bit will be changed.
     /// \param position - bit position.
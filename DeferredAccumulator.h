@@ -0,0 +1,335 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+
+#include "LimbArray.h"
+#include "VariableFloat.h"
+
+template<int fraction, int exponent, u_int guard = 1>
+/// Running sum of VariableFloat numbers with deferred normalization and rounding.
+/// The sum is kept unnormalized in a sign and magnitude register of 'fractionLimbs' + 'guard' + 1 limbs: guard limbs
+/// below the fraction and a limb of headroom above it. An addition only aligns the summand (a number or an exact
+/// product) and adds (or subtracts) limbs, the register is normalized when the headroom runs out or a summand would lose
+/// bits that the register could keep, and rounded only when the result is read. Bits of a summand more than 'guard'
+/// limbs below the fraction of the running sum (or of the register when it is shifted right) are dropped, only their
+/// signs are kept. They take part in rounding as a sticky bit when they all have the same sign and lie below the lowest
+/// bit of the final register, so a sum that cancels exactly gives zero. Each dropped part is smaller than
+/// 2^(-64 * 'guard') ulp of the larger of the running sum and the summand at the time, and the result differs from
+/// the exact sum by at most half an ulp plus the dropped parts. With 'fractionLimbs' + 1 guard limbs exact products
+/// fit in the register whole and a sum of two terms is always rounded once.
+/// \tparam fraction - fraction bit count.
+/// \tparam exponent - exponent bit count (at most 62, so that bit weights fit in a native integer).
+/// \tparam guard - limb count kept below the fraction of the running sum.
+class DeferredAccumulator
+{
+public:
+    typedef VariableFloat<fraction, exponent> Float;
+
+    static_assert(exponent >= 2 && exponent <= 62, "DeferredAccumulator supports exponents of 2 to 62 bits.");
+    static_assert(guard >= 1, "DeferredAccumulator needs at least one guard limb.");
+
+    /// Register limb count (fraction, guard limbs and headroom limb).
+    static constexpr u_int WIDTH = Float::fractionLimbs + guard + 1;
+
+    /// Significant bits of a normalized register, leaving the highest limb free for carries.
+    static constexpr long long NORMAL_BITS = 64 * (long long) (WIDTH - 1);
+
+    /// Creates an accumulator holding zero.
+    DeferredAccumulator() = default;
+
+    /// Adds a number to the running sum.
+    /// \param value - summand.
+    void add(const Float &value) { accumulate(value, value.getSign()); }
+
+    /// Subtracts a number from the running sum.
+    /// \param value - subtrahend.
+    void subtract(const Float &value) { accumulate(value, !value.getSign()); }
+
+    /// Adds a product of two numbers to the running sum without rounding the product first.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    void addProduct(const Float &n1, const Float &n2) { accumulateProduct(n1, n2, n1.getSign() != n2.getSign()); }
+
+    /// Subtracts a product of two numbers from the running sum without rounding the product first.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    void subtractProduct(const Float &n1, const Float &n2) { accumulateProduct(n1, n2, n1.getSign() == n2.getSign()); }
+
+    /// Resets the running sum to zero.
+    void clear() { *this = DeferredAccumulator<fraction, exponent, guard>(); }
+
+    /// Normalizes and rounds the running sum and stores it in 'value' (the accumulator is left unchanged).
+    /// Zero gives positive zero, infinities of both signs or a NaN summand give NaN.
+    /// \param value - destination.
+    void result(Float &value) const;
+
+    /// Normalizes and rounds the running sum.
+    /// \return Running sum.
+    Float result() const;
+
+    /// Adds 'value' to the running sum.
+    /// \param value - summand.
+    DeferredAccumulator<fraction, exponent, guard> &operator+=(const Float &value)
+    {
+        add(value);
+        return *this;
+    }
+
+    /// Subtracts 'value' from the running sum.
+    /// \param value - subtrahend.
+    DeferredAccumulator<fraction, exponent, guard> &operator-=(const Float &value)
+    {
+        subtract(value);
+        return *this;
+    }
+
+private:
+    /// Magnitude of the running sum, least significant limb first.
+    std::array<u_int64_t, WIDTH> limbs{};
+
+    /// Sign of the running sum.
+    bool negative = false;
+
+    /// Weight (power of two) of the register's lowest order bit.
+    long long weight = 0;
+
+    /// Upper bound of the register's significant bit count (0 - the register holds no summand yet).
+    long long used = 0;
+
+    /// Signs of the parts dropped below the register.
+    bool droppedPositive = false;
+    bool droppedNegative = false;
+
+    /// Largest weight of the register's lowest order bit at the time a part was dropped below it.
+    long long droppedWeight = 0;
+
+    /// Special values added so far.
+    bool nan = false;
+    bool positiveInfinity = false;
+    bool negativeInfinity = false;
+
+    /// Returns the unbiased exponent of a number.
+    /// \param value - number (not zero, infinity or NaN).
+    /// \return Unbiased exponent.
+    static long long unbiasedExponent(const Float &value)
+    {
+        return (long long) value.getExponentContainer()[0] - ((1LL << (exponent - 1)) - 1);
+    }
+
+    /// Adds a number with a given sign to the running sum.
+    /// \param value - summand.
+    /// \param valueSign - sign the summand is added with (true - negative).
+    void accumulate(const Float &value, bool valueSign);
+
+    /// Adds an exact product of two numbers with a given sign to the running sum.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    /// \param productSign - sign the product is added with (true - negative).
+    void accumulateProduct(const Float &n1, const Float &n2, bool productSign);
+
+    /// Adds a magnitude with a given sign to the running sum.
+    /// \param value - magnitude limbs (highest order limb not zero).
+    /// \param size - limb count of 'value' (at most 2 * fractionLimbs).
+    /// \param valueWeight - weight of the lowest order bit of 'value'.
+    /// \param valueSign - sign the magnitude is added with (true - negative).
+    void accumulateLimbs(const u_int64_t *value, u_int size, long long valueWeight, bool valueSign);
+
+    /// Counts significant bits of the register exactly.
+    /// \return Bit count of the magnitude.
+    long long significantBits() const;
+
+    /// Shifts the register, so that a value of 'bits' significant bits would fill 'NORMAL_BITS'.
+    /// \param bits - significant bit count (relative to the current weight) the register is normalized for.
+    void normalize(long long bits);
+
+    /// Records a non-zero part dropped below the register's lowest order bit.
+    /// \param sign - sign of the dropped part (true - negative).
+    void drop(bool sign);
+};
+
+template<int fraction, int exponent, u_int guard>
+constexpr u_int DeferredAccumulator<fraction, exponent, guard>::WIDTH;
+
+template<int fraction, int exponent, u_int guard>
+constexpr long long DeferredAccumulator<fraction, exponent, guard>::NORMAL_BITS;
+
+template<int fraction, int exponent, u_int guard>
+void DeferredAccumulator<fraction, exponent, guard>::accumulate(const Float &value, bool valueSign)
+{
+    const u_int size = Float::fractionLimbs;
+    if (value.isSpecial())
+    {
+        if (value.isNan()) nan = true;
+        else if (value.isInfinity() && valueSign) negativeInfinity = true;
+        else if (value.isInfinity()) positiveInfinity = true;
+        return;
+    }
+    accumulateLimbs(value.getFractionContainer().data(), size,
+                    unbiasedExponent(value) - (64 * (long long) size - 1), valueSign);
+}
+
+template<int fraction, int exponent, u_int guard>
+void DeferredAccumulator<fraction, exponent, guard>::accumulateProduct(const Float &n1, const Float &n2,
+                                                                      bool productSign)
+{
+    const u_int size = Float::fractionLimbs;
+    if (n1.isSpecial() || n2.isSpecial())
+    {
+        //Infinity times zero is NaN, zero times a finite number adds nothing.
+        if (n1.isNan() || n2.isNan() || (n1.isInfinity() && n2.isZero()) || (n1.isZero() && n2.isInfinity()))
+            nan = true;
+        else if ((n1.isInfinity() || n2.isInfinity()) && productSign) negativeInfinity = true;
+        else if (n1.isInfinity() || n2.isInfinity()) positiveInfinity = true;
+        return;
+    }
+
+    //Product of fractions is exact, its lowest order bit has a weight of 2^(e1 + e2 - 2 * (64 * size - 1)).
+    std::array<u_int64_t, 2 * size> product;
+    LimbArray::multiplyLimbs(product.data(), n1.getFractionContainer().data(), size,
+                             n2.getFractionContainer().data(), size);
+    accumulateLimbs(product.data(), 2 * size,
+                    unbiasedExponent(n1) + unbiasedExponent(n2) - 2 * (64 * (long long) size - 1), productSign);
+}
+
+template<int fraction, int exponent, u_int guard>
+void DeferredAccumulator<fraction, exponent, guard>::accumulateLimbs(const u_int64_t *value, u_int size,
+                                                                    long long valueWeight, bool valueSign)
+{
+    //First summand is loaded with its highest order limb just below the headroom limb.
+    if (used == 0)
+    {
+        limbs.fill(0);
+        negative = valueSign;
+        weight = valueWeight + 64 * (long long) size - NORMAL_BITS;
+    }
+
+    //Normalize when the sum could carry out of the register or the summand would lose bits needlessly.
+    long long shift = valueWeight - weight;
+    long long bits = shift + 64 * (long long) size;
+    if (used != 0 && (std::max(used, bits) >= 64 * (long long) WIDTH || shift < 0))
+    {
+        const long long exact = significantBits();
+        if (exact == 0)
+        {
+            used = 0;
+            accumulateLimbs(value, size, valueWeight, valueSign);
+            return;
+        }
+        used = exact;
+        const long long top = std::max(used, bits);
+        if (top >= 64 * (long long) WIDTH || top < NORMAL_BITS)
+        {
+            normalize(top);
+            shift = valueWeight - weight;
+            bits = shift + 64 * (long long) size;
+        }
+    }
+
+    //Align the summand, bits below the register are dropped.
+    std::array<u_int64_t, 2 * Float::fractionLimbs + 1> aligned;
+    std::copy(value, value + size, aligned.begin());
+    aligned[size] = 0;
+    u_int index = 0;
+    if (shift >= 0)
+    {
+        index = (u_int) (shift / 64);
+        LimbArray::shiftLeft(aligned.data(), size + 1, (u_int) (shift % 64));
+    }
+    else if (LimbArray::shiftRightSticky(aligned.data(), size + 1, (u_int) std::min<long long>(-shift, 64 * (size + 1))))
+        drop(valueSign);
+    const u_int count = std::min(size + 1, WIDTH - index);
+
+    if (valueSign == negative)
+    {
+        if (LimbArray::addLimbs(limbs.data() + index, aligned.data(), count))
+            LimbArray::addLimb(limbs.data() + index + count, WIDTH - index - count, 1);
+        used = std::max(used, bits) + 1;
+    }
+    else
+    {
+        //Borrow out of the register means the summand was larger, the difference changes sign.
+        bool borrow = LimbArray::subtractLimbs(limbs.data() + index, aligned.data(), count);
+        if (borrow) borrow = LimbArray::subtractLimb(limbs.data() + index + count, WIDTH - index - count, 1);
+        if (borrow)
+        {
+            LimbArray::negateLimbs(limbs.data(), WIDTH);
+            negative = !negative;
+        }
+        used = std::max(used, bits);
+    }
+}
+
+template<int fraction, int exponent, u_int guard>
+long long DeferredAccumulator<fraction, exponent, guard>::significantBits() const
+{
+    return 64 * (long long) WIDTH - LimbArray::countLeadingZeros(limbs.data(), WIDTH);
+}
+
+template<int fraction, int exponent, u_int guard>
+void DeferredAccumulator<fraction, exponent, guard>::normalize(long long bits)
+{
+    const long long shift = bits - NORMAL_BITS;
+    bool dropped = false;
+    if (shift > 0)
+        dropped = LimbArray::shiftRightSticky(limbs.data(), WIDTH, (u_int) std::min<long long>(shift, 64 * WIDTH));
+    else LimbArray::shiftLeft(limbs.data(), WIDTH, (u_int) -shift);
+    weight += shift;
+    used -= shift;
+    if (dropped) drop(negative);
+}
+
+template<int fraction, int exponent, u_int guard>
+void DeferredAccumulator<fraction, exponent, guard>::drop(bool sign)
+{
+    droppedWeight = droppedPositive || droppedNegative ? std::max(droppedWeight, weight) : weight;
+    if (sign) droppedNegative = true;
+    else droppedPositive = true;
+}
+
+template<int fraction, int exponent, u_int guard>
+void DeferredAccumulator<fraction, exponent, guard>::result(Float &value) const
+{
+    if (nan || (positiveInfinity && negativeInfinity))
+    {
+        value.setNan();
+        return;
+    }
+    else if (positiveInfinity || negativeInfinity)
+    {
+        value.setInfinity(negativeInfinity);
+        return;
+    }
+    else if (used == 0)
+    {
+        value.setZero(false);
+        return;
+    }
+    else if (LimbArray::checkIfZero(limbs.data(), WIDTH))
+    {
+        value.setZero(false);
+        return;
+    }
+
+    //Register is extended by a limb below it, dropped parts of a single sign that lie below its lowest order bit
+    //move the value slightly towards their sign, so that they only act as a sticky bit in rounding.
+    std::array<u_int64_t, WIDTH + 1> significand{};
+    std::copy(limbs.begin(), limbs.end(), significand.begin() + 1);
+    if (droppedPositive != droppedNegative && droppedWeight <= weight)
+    {
+        if (droppedNegative == negative) significand[0] = 1;
+        else LimbArray::subtractLimb(significand.data(), WIDTH + 1, 1);
+    }
+
+    typename Float::ExponentWork resultExponent = Float::loadExponent(Float::getBias());
+    Float::adjustExponent(resultExponent, weight + 64 * (long long) WIDTH - 1);
+    value.setResult(negative, resultExponent, significand.data(), WIDTH + 1);
+}
+
+template<int fraction, int exponent, u_int guard>
+VariableFloat<fraction, exponent> DeferredAccumulator<fraction, exponent, guard>::result() const
+{
+    Float value;
+    result(value);
+    return value;
+}
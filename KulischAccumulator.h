@@ -0,0 +1,370 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <vector>
+
+#include "LimbArray.h"
+#include "ScratchArena.h"
+#include "VariableFloat.h"
+
+template<int fraction, int exponent>
+/// Exact (Kulisch style) accumulator for sums and dot products of VariableFloat numbers.
+/// Summands and exact products are added into a wide two's complement fixed point register with a shift
+/// and a limb addition, without normalization or rounding. The register is rounded once when the result is read,
+/// so the result is the exactly rounded sum regardless of the order of additions.
+/// Register covering the whole range of products is held inline in the accumulator (no allocation) when it is
+/// at most INLINE_LIMBS long, its two limbs above the largest product leave room for more than 2^120 of them.
+/// Otherwise only the range of values added so far is kept in a vector and it grows on demand.
+/// \tparam fraction - fraction bit count.
+/// \tparam exponent - exponent bit count (at most 62, so that bit weights fit in a native integer).
+class KulischAccumulator
+{
+public:
+    typedef VariableFloat<fraction, exponent> Float;
+
+    static_assert(exponent >= 2 && exponent <= 62, "KulischAccumulator supports exponents of 2 to 62 bits.");
+
+    /// Exponent bias of the representation.
+    static constexpr long long BIAS = (1LL << (exponent - 1)) - 1;
+
+    /// Weight (power of two) of the lowest order bit of any product of two numbers.
+    static constexpr long long LOWEST_WEIGHT = 2 * (1 - BIAS) - 2 * (64 * (long long) Float::fractionLimbs - 1);
+
+    /// Weight of the highest order bit of any product of two numbers.
+    static constexpr long long HIGHEST_WEIGHT = 2 * BIAS + 1;
+
+    /// Limb count of a register covering all aligned products, with a sign limb of headroom for carries.
+    static constexpr long long RANGE_LIMBS = (HIGHEST_WEIGHT >> 6) - (LOWEST_WEIGHT >> 6) + 3;
+
+    /// Largest register (in limbs) held inline.
+    static constexpr long long INLINE_LIMBS = 4096;
+
+    /// Whether the register covering the whole range is held inline.
+    static constexpr bool INLINE = RANGE_LIMBS <= INLINE_LIMBS;
+
+    /// Creates an accumulator holding zero.
+    KulischAccumulator() = default;
+
+    /// Adds a number to the accumulator.
+    /// \param value - summand.
+    void add(const Float &value);
+
+    /// Subtracts a number from the accumulator.
+    /// \param value - subtrahend.
+    void subtract(const Float &value);
+
+    /// Adds an exact (unrounded) product of two numbers to the accumulator.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    void addProduct(const Float &n1, const Float &n2);
+
+    /// Adds the contents of another accumulator, e.g. a partial sum of a parallel reduction.
+    /// \param other - accumulator to be merged, it is left unchanged.
+    void merge(const KulischAccumulator<fraction, exponent> &other);
+
+    /// Resets the accumulator to zero (register memory is kept).
+    void clear();
+
+    /// Rounds the accumulated value once and stores it in 'value'.
+    /// Exact zero gives positive zero, infinities of both signs or a NaN summand give NaN.
+    /// \param value - destination.
+    void result(Float &value) const;
+
+    /// Rounds the accumulated value once.
+    /// \return Accumulated value.
+    Float result() const;
+
+    /// Adds 'value' to the accumulator.
+    /// \param value - summand.
+    void operator+=(const Float &value) { add(value); }
+
+    /// Subtracts 'value' from the accumulator.
+    /// \param value - subtrahend.
+    void operator-=(const Float &value) { subtract(value); }
+
+    /// Merges 'other' into the accumulator.
+    /// \param other - accumulator to be merged.
+    void operator+=(const KulischAccumulator<fraction, exponent> &other) { merge(other); }
+
+private:
+    /// Inline register of the whole range or a vector grown on demand.
+    typedef typename std::conditional<INLINE, std::array<u_int64_t, (std::size_t) (INLINE ? RANGE_LIMBS : 1)>,
+                                      std::vector<u_int64_t>>::type Register;
+
+    /// Two's complement register, least significant limb first. The highest limb holds the sign and carries
+    /// out of the limbs below it.
+    Register limbs{};
+
+    /// Weight of the register's lowest order limb in limbs (bit 0 of limbs[0] has a weight of 2^(64 * lowest)).
+    long long lowest = INLINE ? LOWEST_WEIGHT >> 6 : 0;
+
+    /// Special values added so far.
+    bool nan = false;
+    bool positiveInfinity = false;
+    bool negativeInfinity = false;
+
+    /// Returns the unbiased exponent of a number.
+    /// \param value - number (not zero, infinity or NaN).
+    /// \return Unbiased exponent.
+    static long long unbiasedExponent(const Float &value) { return (long long) value.getExponentContainer()[0] - BIAS; }
+
+    /// Records an infinity or NaN summand.
+    /// \param isNan - 1 if the summand is NaN.
+    /// \param negative - sign of an infinite summand.
+    void addSpecial(bool isNan, bool negative);
+
+    /// Extends the register, so that it holds limbs 'low' .. 'high' (limb weights) and a sign limb above them.
+    /// Register grows by at least half of its size to keep the cost of growing amortized constant.
+    /// \param low - weight of the lowest order limb that has to be present.
+    /// \param high - weight of the highest order limb that has to be present below the sign limb.
+    void cover(long long low, long long high) { cover(low, high, std::integral_constant<bool, INLINE>()); }
+
+    /// Inline register already covers the whole range.
+    void cover(long long, long long, std::true_type) {}
+
+    /// Extends a register grown on demand.
+    void cover(long long low, long long high, std::false_type);
+
+    /// Adds or subtracts a magnitude at a given weight.
+    /// \param negative - if true then subtracted, otherwise added.
+    /// \param value - magnitude limbs.
+    /// \param size - limb count of 'value' (at most 2 * fractionLimbs).
+    /// \param weight - weight of the lowest order bit of 'value'.
+    void addMagnitude(bool negative, const u_int64_t *value, u_int size, long long weight);
+};
+
+template<int fraction, int exponent>
+constexpr long long KulischAccumulator<fraction, exponent>::BIAS;
+
+template<int fraction, int exponent>
+constexpr long long KulischAccumulator<fraction, exponent>::LOWEST_WEIGHT;
+
+template<int fraction, int exponent>
+constexpr long long KulischAccumulator<fraction, exponent>::HIGHEST_WEIGHT;
+
+template<int fraction, int exponent>
+constexpr long long KulischAccumulator<fraction, exponent>::RANGE_LIMBS;
+
+template<int fraction, int exponent>
+constexpr long long KulischAccumulator<fraction, exponent>::INLINE_LIMBS;
+
+template<int fraction, int exponent>
+constexpr bool KulischAccumulator<fraction, exponent>::INLINE;
+
+template<int fraction, int exponent>
+void KulischAccumulator<fraction, exponent>::add(const Float &value)
+{
+    if (value.isSpecial())
+    {
+        if (!value.isZero()) addSpecial(value.isNan(), value.getSign());
+        return;
+    }
+    addMagnitude(value.getSign(), value.getFractionContainer().data(), Float::fractionLimbs,
+                 unbiasedExponent(value) - (64 * Float::fractionLimbs - 1));
+}
+
+template<int fraction, int exponent>
+void KulischAccumulator<fraction, exponent>::subtract(const Float &value)
+{
+    if (value.isSpecial())
+    {
+        if (!value.isZero()) addSpecial(value.isNan(), !value.getSign());
+        return;
+    }
+    addMagnitude(!value.getSign(), value.getFractionContainer().data(), Float::fractionLimbs,
+                 unbiasedExponent(value) - (64 * Float::fractionLimbs - 1));
+}
+
+template<int fraction, int exponent>
+void KulischAccumulator<fraction, exponent>::addProduct(const Float &n1, const Float &n2)
+{
+    const u_int size = Float::fractionLimbs;
+    const bool productSign = n1.getSign() != n2.getSign();
+
+    if (n1.isSpecial() || n2.isSpecial())
+    {
+        //Infinity times zero is NaN, zero times a finite number adds nothing.
+        if (n1.isNan() || n2.isNan() || (n1.isInfinity() && n2.isZero()) || (n1.isZero() && n2.isInfinity()))
+            addSpecial(true, false);
+        else if (n1.isInfinity() || n2.isInfinity()) addSpecial(false, productSign);
+        return;
+    }
+
+    //Product of fractions is exact, its lowest order bit has a weight of 2^(e1 + e2 - 2 * (64 * size - 1)).
+    std::array<u_int64_t, 2 * size> product;
+    LimbArray::multiplyLimbs(product.data(), n1.getFractionContainer().data(), size,
+                             n2.getFractionContainer().data(), size);
+    addMagnitude(productSign, product.data(), 2 * size,
+                 unbiasedExponent(n1) + unbiasedExponent(n2) - 2 * (64 * (long long) size - 1));
+}
+
+template<int fraction, int exponent>
+void KulischAccumulator<fraction, exponent>::merge(const KulischAccumulator<fraction, exponent> &other)
+{
+    nan |= other.nan;
+    positiveInfinity |= other.positiveInfinity;
+    negativeInfinity |= other.negativeInfinity;
+    if (other.limbs.empty()) return;
+
+    //A carry may have reached the highest limb of the other register, so only limbs that merely extend the sign
+    //of the limb below them are skipped, the remaining ones are added and sign extended from their highest bit.
+    const u_int64_t fill = (other.limbs.back() >> 63) ? ~(u_int64_t) 0 : 0;
+    u_int size = (u_int) other.limbs.size();
+    while (size > 1 && other.limbs[size - 1] == fill && (other.limbs[size - 2] >> 63) == (fill & 1)) --size;
+    cover(other.lowest, other.lowest + size - 1);
+    u_int64_t *target = limbs.data() + (other.lowest - lowest);
+    const u_int rest = (u_int) (limbs.size() - (other.lowest - lowest) - size);
+
+    bool carry = LimbArray::addLimbs(target, other.limbs.data(), size);
+    if (fill != 0) LimbArray::subtractLimb(target + size, rest, 1);
+    if (carry) LimbArray::addLimb(target + size, rest, 1);
+}
+
+template<int fraction, int exponent>
+void KulischAccumulator<fraction, exponent>::clear()
+{
+    std::fill(limbs.begin(), limbs.end(), 0);
+    nan = positiveInfinity = negativeInfinity = false;
+}
+
+template<int fraction, int exponent>
+void KulischAccumulator<fraction, exponent>::result(Float &value) const
+{
+    const u_int size = Float::fractionLimbs;
+    if (nan || (positiveInfinity && negativeInfinity))
+    {
+        value.setNan();
+        return;
+    }
+    else if (positiveInfinity || negativeInfinity)
+    {
+        value.setInfinity(negativeInfinity);
+        return;
+    }
+
+    //Negative register is rounded as a magnitude.
+    ScratchArena::Frame frame;
+    const u_int64_t *magnitude = limbs.data();
+    const bool negative = !limbs.empty() && (limbs.back() >> 63);
+    if (negative)
+    {
+        u_int64_t *negated = frame.allocate(limbs.size());
+        std::copy(limbs.begin(), limbs.end(), negated);
+        LimbArray::negateLimbs(negated, (u_int) limbs.size());
+        magnitude = negated;
+    }
+
+    long long top = (long long) limbs.size() - 1;
+    while (top >= 0 && magnitude[top] == 0) --top;
+    if (top < 0)
+    {
+        value.setZero(false);
+        return;
+    }
+
+    //Highest limb may hold a single bit, so 'size' + 2 limbs keep a whole limb below the rounding position.
+    //Everything below them only contributes the sticky bit.
+    const u_int taken = size + 2;
+    std::array<u_int64_t, taken> significand{};
+    for (u_int i = 0; i < taken; ++i)
+        if (top + 1 - taken + i >= 0) significand[i] = magnitude[top + 1 - taken + i];
+    if (top + 1 > taken && !LimbArray::checkIfZero(magnitude, (u_int) (top + 1 - taken))) significand[0] |= 1;
+
+    typename Float::ExponentWork resultExponent = Float::loadExponent(Float::getBias());
+    Float::adjustExponent(resultExponent, 64 * (lowest + top + 1) - 1);
+    value.setResult(negative, resultExponent, significand.data(), taken);
+}
+
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> KulischAccumulator<fraction, exponent>::result() const
+{
+    Float value;
+    result(value);
+    return value;
+}
+
+template<int fraction, int exponent>
+void KulischAccumulator<fraction, exponent>::addSpecial(bool isNan, bool negative)
+{
+    if (isNan) nan = true;
+    else if (negative) negativeInfinity = true;
+    else positiveInfinity = true;
+}
+
+template<int fraction, int exponent>
+void KulischAccumulator<fraction, exponent>::cover(long long low, long long high, std::false_type)
+{
+    if (limbs.empty())
+    {
+        lowest = low;
+        limbs.assign((std::size_t) (high - low + 2), 0);
+        return;
+    }
+
+    if (low < lowest)
+    {
+        const long long extra = std::max<long long>(lowest - low, (long long) limbs.size() / 2);
+        limbs.insert(limbs.begin(), (std::size_t) extra, 0);
+        lowest -= extra;
+    }
+
+    //Highest limb has to stay a pure sign extension above 'high', so that the addition cannot overflow.
+    const long long top = lowest + (long long) limbs.size() - 1;
+    const u_int64_t fill = (limbs.back() >> 63) ? ~(u_int64_t) 0 : 0;
+    const bool extension = limbs.back() == fill && (limbs.size() < 2 || (limbs[limbs.size() - 2] >> 63) == (fill & 1));
+    if (high >= top || !extension)
+    {
+        const long long extra = std::max<long long>(high + 2 - (top + 1), (long long) limbs.size() / 2);
+        limbs.insert(limbs.end(), (std::size_t) std::max<long long>(extra, 1), fill);
+    }
+}
+
+template<int fraction, int exponent>
+void KulischAccumulator<fraction, exponent>::addMagnitude(bool negative, const u_int64_t *value, u_int size,
+                                                          long long weight)
+{
+    //Align the value to limb boundaries, one more limb takes the bits shifted out of the top.
+    const long long index = weight >> 6;
+    std::array<u_int64_t, 2 * Float::fractionLimbs + 1> shifted;
+    std::copy(value, value + size, shifted.begin());
+    shifted[size] = 0;
+    LimbArray::shiftLeft(shifted.data(), size + 1, (u_int) (weight - index * 64));
+
+    cover(index, index + size);
+    u_int64_t *target = limbs.data() + (index - lowest);
+    const u_int rest = (u_int) (limbs.size() - (index - lowest) - (size + 1));
+
+    //Carry (borrow) usually stops within a limb or two above the value.
+    if (negative)
+    {
+        if (LimbArray::subtractLimbs(target, shifted.data(), size + 1)) LimbArray::subtractLimb(target + size + 1, rest, 1);
+    }
+    else if (LimbArray::addLimbs(target, shifted.data(), size + 1)) LimbArray::addLimb(target + size + 1, rest, 1);
+}
+
+
+/// Exactly rounded reductions, the result does not depend on the order of elements.
+namespace vf
+{
+    /// Stores the sum of 'count' numbers, rounded once, in 'out'.
+    template<int fraction, int exponent>
+    void sum(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> *values,
+             std::size_t count)
+    {
+        KulischAccumulator<fraction, exponent> accumulator;
+        for (std::size_t i = 0; i < count; ++i) accumulator.add(values[i]);
+        accumulator.result(out);
+    }
+
+    /// Stores the dot product of 'count' element spans, rounded once, in 'out'.
+    template<int fraction, int exponent>
+    void dot(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> *a,
+             const VariableFloat<fraction, exponent> *b, std::size_t count)
+    {
+        KulischAccumulator<fraction, exponent> accumulator;
+        for (std::size_t i = 0; i < count; ++i) accumulator.addProduct(a[i], b[i]);
+        accumulator.result(out);
+    }
+}
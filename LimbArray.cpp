@@ -0,0 +1,988 @@
+#include "LimbArray.h"
+#include "ScratchArena.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+LimbArray::Kernel LimbArray::kernel = LimbArray::detectKernel();
+
+LimbArray::Kernel LimbArray::detectKernel()
+{
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("adx") && __builtin_cpu_supports("bmi2")) return Kernel::Adx;
+#endif
+    return Kernel::Portable;
+}
+
+void LimbArray::setKernel(Kernel requested)
+{
+    kernel = requested == Kernel::Adx ? detectKernel() : Kernel::Portable;
+}
+
+const char *LimbArray::getKernelName(Kernel value)
+{
+    return value == Kernel::Adx ? "ADX/BMI2" : "przenosne";
+}
+
+bool LimbArray::addLimbs(u_int64_t *first, const u_int64_t *second, u_int size)
+{
+    return kernel == Kernel::Adx ? addLimbsAdx(first, second, size) : addLimbsPortable(first, second, size);
+}
+
+bool LimbArray::addLimbsPortable(u_int64_t *first, const u_int64_t *second, u_int size)
+{
+    u_int64_t carry = 0;
+    for (u_int i = 0; i < size; ++i)
+    {
+        u_int128_t part = (u_int128_t) first[i] + second[i] + carry;
+        first[i] = (u_int64_t) part;
+        carry = (u_int64_t) (part >> LIMB_BITS);
+    }
+    return carry;
+}
+
+bool LimbArray::addLimb(u_int64_t *first, u_int size, u_int64_t value)
+{
+    for (u_int i = 0; i < size && value != 0; ++i)
+    {
+        first[i] += value;
+        value = first[i] < value ? 1 : 0;
+    }
+    return value;
+}
+
+bool LimbArray::subtractLimbs(u_int64_t *first, const u_int64_t *second, u_int size)
+{
+    return kernel == Kernel::Adx ? subtractLimbsAdx(first, second, size) : subtractLimbsPortable(first, second, size);
+}
+
+bool LimbArray::subtractLimbsPortable(u_int64_t *first, const u_int64_t *second, u_int size)
+{
+    u_int64_t borrow = 0;
+    for (u_int i = 0; i < size; ++i)
+    {
+        u_int128_t part = (u_int128_t) first[i] - second[i] - borrow;
+        first[i] = (u_int64_t) part;
+        borrow = (u_int64_t) (part >> LIMB_BITS) & 1;
+    }
+    return borrow;
+}
+
+bool LimbArray::subtractLimb(u_int64_t *first, u_int size, u_int64_t value)
+{
+    for (u_int i = 0; i < size && value != 0; ++i)
+    {
+        u_int64_t previous = first[i];
+        first[i] -= value;
+        value = first[i] > previous ? 1 : 0;
+    }
+    return value;
+}
+
+int LimbArray::compare(const u_int64_t *first, const u_int64_t *second, u_int size)
+{
+    for (int i = size - 1; i >= 0; --i)
+    {
+        if (first[i] != second[i]) return first[i] > second[i] ? 1 : -1;
+    }
+    return 0;
+}
+
+bool LimbArray::checkIfZero(const u_int64_t *first, u_int size)
+{
+    for (u_int i = 0; i < size; ++i)
+        if (first[i] != 0) return false;
+    return true;
+}
+
+void LimbArray::shiftLeft(u_int64_t *limbs, u_int size, u_int shift)
+{
+    shiftLeft(limbs, limbs, size, shift);
+}
+
+void LimbArray::shiftLeft(u_int64_t *destination, const u_int64_t *source, u_int size, u_int shift)
+{
+    u_int limbShift = std::min(shift / LIMB_BITS, size);
+    u_int bitShift = shift % LIMB_BITS;
+
+    //Whole limb move when shift is a multiple of limb size, otherwise a funnel shift of neighbouring limbs.
+    //Limbs are written from the highest order one, so that destination may be the same as source.
+    if (limbShift < size)
+    {
+        if (bitShift == 0)
+        {
+            for (u_int i = size - 1; i > limbShift; --i) destination[i] = source[i - limbShift];
+        }
+        else
+        {
+            for (u_int i = size - 1; i > limbShift; --i)
+            {
+                destination[i] = (source[i - limbShift] << bitShift) |
+                                 (source[i - limbShift - 1] >> (LIMB_BITS - bitShift));
+            }
+        }
+        destination[limbShift] = source[0] << bitShift;
+    }
+    for (u_int i = 0; i < limbShift; ++i) destination[i] = 0;
+}
+
+void LimbArray::shiftRight(u_int64_t *limbs, u_int size, u_int shift)
+{
+    shiftRight(limbs, limbs, size, shift);
+}
+
+void LimbArray::shiftRight(u_int64_t *destination, const u_int64_t *source, u_int size, u_int shift)
+{
+    u_int limbShift = std::min(shift / LIMB_BITS, size);
+    u_int bitShift = shift % LIMB_BITS;
+    u_int kept = size - limbShift;
+
+    //Limbs are written from the lowest order one, so that destination may be the same as source.
+    if (kept != 0)
+    {
+        if (bitShift == 0)
+        {
+            for (u_int i = 0; i + 1 < kept; ++i) destination[i] = source[i + limbShift];
+        }
+        else
+        {
+            for (u_int i = 0; i + 1 < kept; ++i)
+            {
+                destination[i] = (source[i + limbShift] >> bitShift) |
+                                 (source[i + limbShift + 1] << (LIMB_BITS - bitShift));
+            }
+        }
+        destination[kept - 1] = source[size - 1] >> bitShift;
+    }
+    for (u_int i = kept; i < size; ++i) destination[i] = 0;
+}
+
+bool LimbArray::shiftRightSticky(u_int64_t *limbs, u_int size, u_int shift)
+{
+    u_int limbShift = std::min(shift / LIMB_BITS, size);
+    u_int bitShift = shift % LIMB_BITS;
+
+    //Check bits that are going to be shifted out.
+    bool sticky = !checkIfZero(limbs, limbShift);
+    if (limbShift < size && bitShift != 0) sticky |= (limbs[limbShift] & (((u_int64_t) 1 << bitShift) - 1)) != 0;
+
+    shiftRight(limbs, size, shift);
+    return sticky;
+}
+
+u_int64_t LimbArray::multiplyAddLimb(u_int64_t *result, const u_int64_t *first, u_int size, u_int64_t multiplier)
+{
+    if (kernel == Kernel::Adx) return multiplyAddLimbAdx(result, first, size, multiplier);
+    return multiplyAddLimbPortable(result, first, size, multiplier);
+}
+
+u_int64_t LimbArray::multiplyAddLimbPortable(u_int64_t *result, const u_int64_t *first, u_int size,
+                                             u_int64_t multiplier)
+{
+    u_int64_t carry = 0;
+    for (u_int i = 0; i < size; ++i)
+    {
+        u_int128_t part = (u_int128_t) first[i] * multiplier + result[i] + carry;
+        result[i] = (u_int64_t) part;
+        carry = (u_int64_t) (part >> LIMB_BITS);
+    }
+    return carry;
+}
+
+#ifdef __x86_64__
+//Loops below keep carries in flags between iterations, so only instructions that do not modify the flags
+//the loop depends on are used for bookkeeping (lea, mov, jrcxz; dec changes OF but keeps CF).
+//Limbs that do not fill a whole block of four are processed first.
+
+__attribute__((target("adx")))
+bool LimbArray::addLimbsAdx(u_int64_t *first, const u_int64_t *second, u_int size)
+{
+    u_int64_t count = size % 4;
+    u_int64_t blocks = size / 4;
+    u_int64_t limb;
+    u_char carry;
+    asm volatile(
+        "xor %[limb], %[limb]\n\t"
+        "jrcxz 2f\n"
+        "1:\n\t"
+        "mov (%[first]), %[limb]\n\t"
+        "adcx (%[second]), %[limb]\n\t"
+        "mov %[limb], (%[first])\n\t"
+        "lea 8(%[first]), %[first]\n\t"
+        "lea 8(%[second]), %[second]\n\t"
+        "dec %[count]\n\t"
+        "jnz 1b\n"
+        "2:\n\t"
+        "mov %[blocks], %[count]\n\t"
+        "jrcxz 4f\n"
+        "3:\n\t"
+        "mov (%[first]), %[limb]\n\t"
+        "adcx (%[second]), %[limb]\n\t"
+        "mov %[limb], (%[first])\n\t"
+        "mov 8(%[first]), %[limb]\n\t"
+        "adcx 8(%[second]), %[limb]\n\t"
+        "mov %[limb], 8(%[first])\n\t"
+        "mov 16(%[first]), %[limb]\n\t"
+        "adcx 16(%[second]), %[limb]\n\t"
+        "mov %[limb], 16(%[first])\n\t"
+        "mov 24(%[first]), %[limb]\n\t"
+        "adcx 24(%[second]), %[limb]\n\t"
+        "mov %[limb], 24(%[first])\n\t"
+        "lea 32(%[first]), %[first]\n\t"
+        "lea 32(%[second]), %[second]\n\t"
+        "dec %[count]\n\t"
+        "jnz 3b\n"
+        "4:\n\t"
+        "setc %[carry]"
+        : [first] "+r"(first), [second] "+r"(second), [count] "+c"(count), [limb] "=&r"(limb),
+          [carry] "=r"(carry)
+        : [blocks] "r"(blocks)
+        : "cc", "memory");
+    return carry;
+}
+
+bool LimbArray::subtractLimbsAdx(u_int64_t *first, const u_int64_t *second, u_int size)
+{
+    //There is no flag-only subtraction counterpart of adcx, a single sbb chain is already optimal.
+    u_int64_t count = size % 4;
+    u_int64_t blocks = size / 4;
+    u_int64_t limb;
+    u_char borrow;
+    asm volatile(
+        "xor %[limb], %[limb]\n\t"
+        "jrcxz 2f\n"
+        "1:\n\t"
+        "mov (%[first]), %[limb]\n\t"
+        "sbb (%[second]), %[limb]\n\t"
+        "mov %[limb], (%[first])\n\t"
+        "lea 8(%[first]), %[first]\n\t"
+        "lea 8(%[second]), %[second]\n\t"
+        "dec %[count]\n\t"
+        "jnz 1b\n"
+        "2:\n\t"
+        "mov %[blocks], %[count]\n\t"
+        "jrcxz 4f\n"
+        "3:\n\t"
+        "mov (%[first]), %[limb]\n\t"
+        "sbb (%[second]), %[limb]\n\t"
+        "mov %[limb], (%[first])\n\t"
+        "mov 8(%[first]), %[limb]\n\t"
+        "sbb 8(%[second]), %[limb]\n\t"
+        "mov %[limb], 8(%[first])\n\t"
+        "mov 16(%[first]), %[limb]\n\t"
+        "sbb 16(%[second]), %[limb]\n\t"
+        "mov %[limb], 16(%[first])\n\t"
+        "mov 24(%[first]), %[limb]\n\t"
+        "sbb 24(%[second]), %[limb]\n\t"
+        "mov %[limb], 24(%[first])\n\t"
+        "lea 32(%[first]), %[first]\n\t"
+        "lea 32(%[second]), %[second]\n\t"
+        "dec %[count]\n\t"
+        "jnz 3b\n"
+        "4:\n\t"
+        "setc %[borrow]"
+        : [first] "+r"(first), [second] "+r"(second), [count] "+c"(count), [limb] "=&r"(limb),
+          [borrow] "=r"(borrow)
+        : [blocks] "r"(blocks)
+        : "cc", "memory");
+    return borrow;
+}
+
+__attribute__((target("adx,bmi2")))
+u_int64_t LimbArray::multiplyAddLimbAdx(u_int64_t *result, const u_int64_t *first, u_int size, u_int64_t multiplier)
+{
+    //Low half of a product is added to the high half of the previous one on the CF chain (adcx),
+    //the sum is added to the result limb on the OF chain (adox). Final carries of both chains
+    //are added to the last high half, which cannot overflow.
+    u_int64_t count = size % 4;
+    u_int64_t blocks = size / 4;
+    u_int64_t low, high, carry;
+    asm volatile(
+        "xor %[carry], %[carry]\n"
+        "1:\n\t"
+        "jrcxz 2f\n\t"
+        "mulx (%[first]), %[low], %[high]\n\t"
+        "adcx %[carry], %[low]\n\t"
+        "adox (%[result]), %[low]\n\t"
+        "mov %[low], (%[result])\n\t"
+        "mov %[high], %[carry]\n\t"
+        "lea 8(%[first]), %[first]\n\t"
+        "lea 8(%[result]), %[result]\n\t"
+        "lea -1(%[count]), %[count]\n\t"
+        "jmp 1b\n"
+        "2:\n\t"
+        "mov %[blocks], %[count]\n"
+        "3:\n\t"
+        "jrcxz 4f\n\t"
+        "mulx (%[first]), %[low], %[high]\n\t"
+        "adcx %[carry], %[low]\n\t"
+        "adox (%[result]), %[low]\n\t"
+        "mov %[low], (%[result])\n\t"
+        "mulx 8(%[first]), %[low], %[carry]\n\t"
+        "adcx %[high], %[low]\n\t"
+        "adox 8(%[result]), %[low]\n\t"
+        "mov %[low], 8(%[result])\n\t"
+        "mulx 16(%[first]), %[low], %[high]\n\t"
+        "adcx %[carry], %[low]\n\t"
+        "adox 16(%[result]), %[low]\n\t"
+        "mov %[low], 16(%[result])\n\t"
+        "mulx 24(%[first]), %[low], %[carry]\n\t"
+        "adcx %[high], %[low]\n\t"
+        "adox 24(%[result]), %[low]\n\t"
+        "mov %[low], 24(%[result])\n\t"
+        "lea 32(%[first]), %[first]\n\t"
+        "lea 32(%[result]), %[result]\n\t"
+        "lea -1(%[count]), %[count]\n\t"
+        "jmp 3b\n"
+        "4:\n\t"
+        "mov $0, %[low]\n\t"
+        "adcx %[low], %[carry]\n\t"
+        "adox %[low], %[carry]"
+        : [result] "+r"(result), [first] "+r"(first), [count] "+c"(count), [low] "=&r"(low),
+          [high] "=&r"(high), [carry] "=&r"(carry)
+        : [blocks] "r"(blocks), "d"(multiplier)
+        : "cc", "memory");
+    return carry;
+}
+#else
+bool LimbArray::addLimbsAdx(u_int64_t *first, const u_int64_t *second, u_int size)
+{
+    return addLimbsPortable(first, second, size);
+}
+
+bool LimbArray::subtractLimbsAdx(u_int64_t *first, const u_int64_t *second, u_int size)
+{
+    return subtractLimbsPortable(first, second, size);
+}
+
+u_int64_t LimbArray::multiplyAddLimbAdx(u_int64_t *result, const u_int64_t *first, u_int size, u_int64_t multiplier)
+{
+    return multiplyAddLimbPortable(result, first, size, multiplier);
+}
+#endif
+
+u_int LimbArray::karatsubaThreshold = 24;
+u_int LimbArray::transformThreshold = 8192;
+u_int LimbArray::parallelThreshold = 1600;
+ThreadPool *LimbArray::threadPool = nullptr;
+
+ThreadPool &LimbArray::getThreadPool()
+{
+    return threadPool != nullptr ? *threadPool : ThreadPool::global();
+}
+
+void LimbArray::runParallel(std::size_t count, std::size_t chunk,
+                            const std::function<void(std::size_t, std::size_t)> &job)
+{
+    getThreadPool().run(count, chunk, job);
+}
+
+void LimbArray::multiplyLimbs(u_int64_t *result, const u_int64_t *first, u_int firstSize,
+                              const u_int64_t *second, u_int secondSize)
+{
+    if (firstSize < secondSize)
+    {
+        std::swap(first, second);
+        std::swap(firstSize, secondSize);
+    }
+    if (secondSize < std::max(karatsubaThreshold, 2u))
+    {
+        multiplySchoolbook(result, first, firstSize, second, secondSize);
+        return;
+    }
+    if (secondSize >= transformThreshold)
+    {
+        multiplyTransform(result, first, firstSize, second, secondSize);
+        return;
+    }
+
+    //Enough sub-products are created to keep every thread busy when some of them finish early.
+    const u_int threads = getThreadPool().getThreadCount();
+    u_int depth = 0;
+    if (secondSize >= parallelThreshold && threads > 1)
+    {
+        for (u_int products = 1; products < 2 * threads && (secondSize >> depth) >= 2 * karatsubaThreshold;
+             products *= 3)
+            ++depth;
+    }
+
+    //Scratch space for all recursion levels is allocated once.
+    ScratchArena::Frame frame;
+    u_int64_t *scratch = depth != 0 ? nullptr : frame.allocate(karatsubaScratchSize(secondSize));
+    if (firstSize == secondSize)
+    {
+        if (depth != 0) multiplyKaratsubaParallel(result, first, second, secondSize, depth);
+        else multiplyKaratsuba(result, first, second, secondSize, scratch);
+        return;
+    }
+
+    //Unbalanced operands, multiply second by 'secondSize' limb chunks of first and accumulate.
+    for (u_int i = 0; i < firstSize + secondSize; ++i) result[i] = 0;
+    u_int64_t *product = frame.allocate(2 * secondSize);
+    u_int64_t *chunk = frame.allocateZeroed(secondSize);
+    for (u_int offset = 0; offset < firstSize; offset += secondSize)
+    {
+        u_int chunkSize = std::min(secondSize, firstSize - offset);
+        const u_int64_t *chunkData = first + offset;
+        if (chunkSize < secondSize)
+        {
+            std::copy(first + offset, first + firstSize, chunk);
+            chunkData = chunk;
+        }
+        if (depth != 0) multiplyKaratsubaParallel(product, chunkData, second, secondSize, depth);
+        else multiplyKaratsuba(product, chunkData, second, secondSize, scratch);
+
+        //Product of the last chunk may be longer than the result remaining after offset, its top limbs are zero.
+        u_int productSize = std::min(2 * secondSize, firstSize + secondSize - offset);
+        bool carry = addLimbs(result + offset, product, productSize);
+        addLimb(result + offset + productSize, firstSize + secondSize - offset - productSize, carry);
+    }
+}
+
+void LimbArray::multiplySchoolbook(u_int64_t *result, const u_int64_t *first, u_int firstSize,
+                                   const u_int64_t *second, u_int secondSize)
+{
+    for (u_int i = 0; i < firstSize + secondSize; ++i) result[i] = 0;
+
+    //Multiply first by each limb of second and accumulate shifted partial products.
+    for (u_int i = 0; i < secondSize; ++i)
+        result[firstSize + i] = multiplyAddLimb(result + i, first, firstSize, second[i]);
+}
+
+u_int LimbArray::karatsubaScratchSize(u_int size)
+{
+    if (size < std::max(karatsubaThreshold, 2u)) return 0;
+    u_int high = size - size / 2;
+    return 6 * high + 1 + karatsubaScratchSize(high);
+}
+
+void LimbArray::multiplyKaratsuba(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                  u_int size, u_int64_t *scratch)
+{
+    if (size < std::max(karatsubaThreshold, 2u))
+    {
+        multiplySchoolbook(result, first, size, second, size);
+        return;
+    }
+
+    //Operands are split into low (h limbs) and high (size - h limbs) halves: x = x1 * B^h + x0.
+    u_int low = size / 2;
+    u_int high = size - low;
+    u_int64_t *firstDifference = scratch;
+    u_int64_t *secondDifference = firstDifference + high;
+    u_int64_t *middle = secondDifference + high;
+    u_int64_t *sum = middle + 2 * high;
+    u_int64_t *next = sum + 2 * high + 1;
+
+    //z0 = x0 * y0 and z2 = x1 * y1 are placed directly in result.
+    multiplyKaratsuba(result, first, second, low, next);
+    multiplyKaratsuba(result + 2 * low, first + low, second + low, high, next);
+
+    //z1 = z0 + z2 - (x1 - x0) * (y1 - y0), differences are kept as magnitudes with a sign.
+    bool negative = absoluteDifference(firstDifference, first + low, high, first, low) !=
+                    absoluteDifference(secondDifference, second + low, high, second, low);
+    multiplyKaratsuba(middle, firstDifference, secondDifference, high, next);
+
+    addKaratsubaMiddle(result, middle, sum, low, high, negative);
+}
+
+void LimbArray::addKaratsubaMiddle(u_int64_t *result, const u_int64_t *middle, u_int64_t *sum, u_int low, u_int high,
+                                   bool negative)
+{
+    for (u_int i = 0; i < 2 * high + 1; ++i) sum[i] = 0;
+    for (u_int i = 0; i < 2 * low; ++i) sum[i] = result[i];
+    sum[2 * high] = addLimbs(sum, result + 2 * low, 2 * high);
+    if (negative) sum[2 * high] += addLimbs(sum, middle, 2 * high);
+    else sum[2 * high] -= subtractLimbs(sum, middle, 2 * high);
+
+    //Add z1 * B^h to the result, the full product always fits in result, so final carry is zero.
+    bool carry = addLimbs(result + low, sum, 2 * high + 1);
+    addLimb(result + low + 2 * high + 1, low - 1, carry);
+}
+
+void LimbArray::multiplyKaratsubaParallel(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                          u_int size, u_int depth)
+{
+    ScratchArena::Frame frame;
+    u_int64_t *scratch = frame.allocate(karatsubaParallelScratchSize(size, depth));
+    //Sub-product list is taken from the arena as well, every expanded level triples it.
+    static_assert(sizeof(Product) % sizeof(u_int64_t) == 0, "Product must fill whole limbs.");
+    std::size_t capacity = 1;
+    for (u_int i = 0; i < depth; ++i) capacity *= 3;
+    Product *products = reinterpret_cast<Product *>(frame.allocate(capacity * sizeof(Product) / sizeof(u_int64_t)));
+    std::size_t count = 0;
+    splitKaratsuba(result, first, second, size, scratch, depth, products, count);
+
+    //Sub-products write disjoint parts of result and scratch, each thread uses its own scratch arena.
+    getThreadPool().run(count, 1, [products](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            ScratchArena::Frame local;
+            const Product &product = products[i];
+            multiplyKaratsuba(product.result, product.first, product.second, product.size,
+                              local.allocate(karatsubaScratchSize(product.size)));
+        }
+    });
+
+    combineKaratsuba(result, size, scratch, depth);
+}
+
+u_int LimbArray::karatsubaParallelScratchSize(u_int size, u_int depth)
+{
+    if (depth == 0 || size < std::max(karatsubaThreshold, 2u)) return 0;
+    u_int low = size / 2;
+    u_int high = size - low;
+    return 6 * high + 2 + karatsubaParallelScratchSize(low, depth - 1) +
+           2 * karatsubaParallelScratchSize(high, depth - 1);
+}
+
+void LimbArray::splitKaratsuba(u_int64_t *result, const u_int64_t *first, const u_int64_t *second, u_int size,
+                               u_int64_t *scratch, u_int depth, Product *products, std::size_t &count)
+{
+    if (depth == 0 || size < std::max(karatsubaThreshold, 2u))
+    {
+        products[count++] = Product{result, first, second, size};
+        return;
+    }
+
+    //Same layout as in 'multiplyKaratsuba', followed by the sign of the middle product
+    //and separate scratch space of each sub-product.
+    u_int low = size / 2;
+    u_int high = size - low;
+    u_int64_t *firstDifference = scratch;
+    u_int64_t *secondDifference = firstDifference + high;
+    u_int64_t *middle = secondDifference + high;
+    u_int64_t *sum = middle + 2 * high;
+    u_int64_t *negative = sum + 2 * high + 1;
+    u_int64_t *next = negative + 1;
+
+    *negative = absoluteDifference(firstDifference, first + low, high, first, low) !=
+                absoluteDifference(secondDifference, second + low, high, second, low);
+
+    splitKaratsuba(result, first, second, low, next, depth - 1, products, count);
+    next += karatsubaParallelScratchSize(low, depth - 1);
+    splitKaratsuba(result + 2 * low, first + low, second + low, high, next, depth - 1, products, count);
+    next += karatsubaParallelScratchSize(high, depth - 1);
+    splitKaratsuba(middle, firstDifference, secondDifference, high, next, depth - 1, products, count);
+}
+
+void LimbArray::combineKaratsuba(u_int64_t *result, u_int size, u_int64_t *scratch, u_int depth)
+{
+    if (depth == 0 || size < std::max(karatsubaThreshold, 2u)) return;
+
+    u_int low = size / 2;
+    u_int high = size - low;
+    u_int64_t *middle = scratch + 2 * high;
+    u_int64_t *sum = middle + 2 * high;
+    u_int64_t *negative = sum + 2 * high + 1;
+    u_int64_t *next = negative + 1;
+
+    combineKaratsuba(result, low, next, depth - 1);
+    next += karatsubaParallelScratchSize(low, depth - 1);
+    combineKaratsuba(result + 2 * low, high, next, depth - 1);
+    next += karatsubaParallelScratchSize(high, depth - 1);
+    combineKaratsuba(middle, high, next, depth - 1);
+
+    addKaratsubaMiddle(result, middle, sum, low, high, *negative != 0);
+}
+
+void LimbArray::multiplyTransform(u_int64_t *result, const u_int64_t *first, u_int firstSize,
+                                  const u_int64_t *second, u_int secondSize)
+{
+    //Operands are split into 16-bit digits, so that convolution sums stay below the modulus.
+    const u_int digits = LIMB_BITS / TRANSFORM_DIGIT_BITS;
+    std::size_t length = 1;
+    while (length < (std::size_t) (firstSize + secondSize) * digits) length <<= 1;
+
+    ScratchArena::Frame frame;
+    u_int64_t *firstDigits = frame.allocateZeroed(length);
+    u_int64_t *secondDigits = frame.allocateZeroed(length);
+    for (std::size_t i = 0; i < (std::size_t) firstSize * digits; ++i)
+        firstDigits[i] = (first[i / digits] >> (TRANSFORM_DIGIT_BITS * (i % digits))) & 0xFFFF;
+    for (std::size_t i = 0; i < (std::size_t) secondSize * digits; ++i)
+        secondDigits[i] = (second[i / digits] >> (TRANSFORM_DIGIT_BITS * (i % digits))) & 0xFFFF;
+
+    //Cyclic convolution: forward transforms, pointwise product and inverse transform.
+    const bool parallel = secondSize >= parallelThreshold && getThreadPool().getThreadCount() > 1;
+    transform(firstDigits, length, false, parallel);
+    transform(secondDigits, length, false, parallel);
+    runRanges(parallel, length, TRANSFORM_CHUNK, [firstDigits, secondDigits](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i) firstDigits[i] = multiplyModular(firstDigits[i], secondDigits[i]);
+    });
+    transform(firstDigits, length, true, parallel);
+
+    //Convolution values are exact, propagate carries between digits.
+    u_int128_t carry = 0;
+    for (u_int i = 0; i < firstSize + secondSize; ++i)
+    {
+        u_int64_t limb = 0;
+        for (u_int j = 0; j < digits; ++j)
+        {
+            carry += firstDigits[(std::size_t) i * digits + j];
+            limb |= ((u_int64_t) carry & 0xFFFF) << (TRANSFORM_DIGIT_BITS * j);
+            carry >>= TRANSFORM_DIGIT_BITS;
+        }
+        result[i] = limb;
+    }
+}
+
+u_int64_t LimbArray::multiplyModular(u_int64_t first, u_int64_t second)
+{
+    //Reduction modulo p = 2^64 - 2^32 + 1 uses 2^64 = 2^32 - 1 and 2^96 = -1 (mod p).
+    const u_int64_t epsilon = 0xFFFFFFFFull;
+    u_int128_t product = (u_int128_t) first * second;
+    u_int64_t low = (u_int64_t) product;
+    u_int64_t high = (u_int64_t) (product >> LIMB_BITS);
+
+    //Corrections are applied with masks instead of branches, which would be unpredictable here.
+    u_int64_t value = low - (high >> 32);
+    value -= epsilon & (0 - (u_int64_t) (low < (high >> 32)));
+    u_int64_t middle = (high & epsilon) * epsilon;
+    u_int64_t sum = value + middle;
+    sum += epsilon & (0 - (u_int64_t) (sum < value));
+    return sum - (TRANSFORM_PRIME & (0 - (u_int64_t) (sum >= TRANSFORM_PRIME)));
+}
+
+u_int64_t LimbArray::powerModular(u_int64_t base, u_int64_t power)
+{
+    u_int64_t result = 1;
+    for (; power != 0; power >>= 1)
+    {
+        if (power & 1) result = multiplyModular(result, base);
+        base = multiplyModular(base, base);
+    }
+    return result;
+}
+
+void LimbArray::transform(u_int64_t *values, std::size_t length, bool inverse, bool parallel)
+{
+    ScratchArena::Frame frame;
+    u_int64_t *twiddles = frame.allocate(length / 2);
+
+    //Forward transform uses decimation in frequency (result in bit reversed order) and inverse transform
+    //uses decimation in time (input in bit reversed order), so that no bit reversal permutation is needed.
+    for (std::size_t step = 0; (std::size_t) 2 << step <= length; ++step)
+    {
+        std::size_t size = inverse ? (std::size_t) 2 << step : length >> step;
+        std::size_t half = size / 2;
+
+        //Twiddle factors are computed once per stage, every range starts from its own power of the root.
+        u_int64_t root = powerModular(TRANSFORM_GENERATOR, (TRANSFORM_PRIME - 1) / size);
+        if (inverse) root = powerModular(root, TRANSFORM_PRIME - 2);
+        runRanges(parallel, half, TRANSFORM_CHUNK, [twiddles, root](std::size_t begin, std::size_t end)
+        {
+            u_int64_t twiddle = powerModular(root, begin);
+            for (std::size_t j = begin; j < end; ++j)
+            {
+                twiddles[j] = twiddle;
+                twiddle = multiplyModular(twiddle, root);
+            }
+        });
+
+        //Butterflies are numbered block by block, 'half' of them in each block of 'size' values.
+        runRanges(parallel, length / 2, TRANSFORM_CHUNK,
+                  [values, twiddles, size, half, inverse](std::size_t begin, std::size_t end)
+        {
+            std::size_t i = begin / half * size;
+            std::size_t j = begin % half;
+            for (std::size_t k = begin; k < end; ++k)
+            {
+                u_int64_t u = values[i + j];
+                u_int64_t v = values[i + j + half];
+                if (inverse) v = multiplyModular(v, twiddles[j]);
+
+                //Modular sum and difference, corrections are applied with masks instead of branches.
+                u_int64_t sum = u + v;
+                sum -= TRANSFORM_PRIME & (0 - (u_int64_t) ((sum < u) | (sum >= TRANSFORM_PRIME)));
+                u_int64_t difference = u - v;
+                difference += TRANSFORM_PRIME & (0 - (u_int64_t) (u < v));
+
+                values[i + j] = sum;
+                values[i + j + half] = inverse ? difference : multiplyModular(difference, twiddles[j]);
+                if (++j == half)
+                {
+                    j = 0;
+                    i += size;
+                }
+            }
+        });
+    }
+
+    //Inverse transform is scaled by 1 / length.
+    if (inverse)
+    {
+        u_int64_t scale = powerModular(length % TRANSFORM_PRIME, TRANSFORM_PRIME - 2);
+        runRanges(parallel, length, TRANSFORM_CHUNK, [values, scale](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i) values[i] = multiplyModular(values[i], scale);
+        });
+    }
+}
+
+u_int LimbArray::newtonPrecisions(u_int precision, u_int *precisions)
+{
+    //Each step roughly doubles precision, one guard limb per step keeps the error from growing between steps.
+    u_int count = 1;
+    precisions[0] = precision;
+    while (precisions[count - 1] > 1)
+    {
+        u_int last = precisions[count - 1];
+        precisions[count++] = last >= 4 ? last / 2 + 1 : last - 1;
+    }
+    std::reverse(precisions, precisions + count);
+    return count;
+}
+
+void LimbArray::truncateLimbs(u_int64_t *result, u_int resultSize, const u_int64_t *first, u_int size)
+{
+    for (u_int i = 0; i < resultSize; ++i)
+        result[i] = i + size >= resultSize ? first[i + size - resultSize] : 0;
+}
+
+void LimbArray::negateLimbs(u_int64_t *limbs, u_int size)
+{
+    for (u_int i = 0; i < size; ++i) limbs[i] = ~limbs[i];
+    addLimb(limbs, size, 1);
+}
+
+void LimbArray::reciprocalLimbs(u_int64_t *reciprocal, u_int precision, const u_int64_t *first, u_int size)
+{
+    ScratchArena::Frame frame;
+    u_int64_t *divisor = frame.allocate(precision);
+    u_int64_t *product = frame.allocate(2 * precision);
+    u_int64_t *error = frame.allocate(2 * precision);
+    u_int64_t *correction = frame.allocate(2 * precision);
+    for (u_int i = 0; i < precision; ++i) reciprocal[i] = 0;
+
+    //Seed from the highest order limb of divisor: 2^126 / d is correct to about 62 bits.
+    reciprocal[0] = (u_int64_t) (((u_int128_t) 1 << 126) / first[size - 1]);
+
+    u_int current = 1;
+    u_int precisions[64];
+    u_int steps = newtonPrecisions(precision, precisions);
+    for (u_int step = 0; step < steps; ++step)
+    {
+        u_int p = precisions[step];
+        //Extend the approximation to p limbs and use p highest order limbs of divisor (d).
+        shiftLeft(reciprocal, p, (p - current) * LIMB_BITS);
+        current = p;
+        truncateLimbs(divisor, p, first, size);
+
+        //Newton step y = y + y * (1 - d * y), where 1 has a weight of 2^(128 * p - 2) in d * Y.
+        multiplyLimbs(product, divisor, p, reciprocal, p);
+        for (u_int i = 0; i < 2 * p; ++i) error[i] = 0;
+        error[2 * p - 1] = (u_int64_t) 1 << (LIMB_BITS - 2);
+        bool negative = subtractLimbs(error, product, 2 * p);
+        if (negative) negateLimbs(error, 2 * p);
+
+        //Lower half of the error is below the approximation precision and is skipped.
+        multiplyLimbs(correction, reciprocal, p, error + p, p);
+        shiftRight(correction, 2 * p, p * LIMB_BITS - 2);
+        if (negative) subtractLimbs(reciprocal, correction, p);
+        else addLimbs(reciprocal, correction, p);
+    }
+}
+
+void LimbArray::reciprocalSquareRootLimbs(u_int64_t *reciprocal, u_int precision, const u_int64_t *first, u_int size)
+{
+    ScratchArena::Frame frame;
+    u_int64_t *radicand = frame.allocate(precision);
+    u_int64_t *square = frame.allocate(2 * precision + 1);
+    u_int64_t *product = frame.allocate(2 * precision + 1);
+    u_int64_t *error = frame.allocate(2 * precision + 1);
+    u_int64_t *correction = frame.allocate(2 * precision + 1);
+    for (u_int i = 0; i < precision; ++i) reciprocal[i] = 0;
+
+    //Seed from hardware square root of the highest order limb (about 50 correct bits).
+    double highest = std::ldexp((double) first[size - 1], -(int) LIMB_BITS);
+    reciprocal[0] = (u_int64_t) std::ldexp(1.0 / std::sqrt(highest), LIMB_BITS - 2);
+
+    u_int current = 1;
+    u_int precisions[64];
+    u_int steps = newtonPrecisions(precision, precisions);
+    for (u_int step = 0; step < steps; ++step)
+    {
+        u_int p = precisions[step];
+        //Extend the approximation to p limbs and use p highest order limbs of radicand (x).
+        shiftLeft(reciprocal, p, (p - current) * LIMB_BITS);
+        current = p;
+        truncateLimbs(radicand, p, first, size);
+
+        //Y^2 scaled to the weight of Y (at most 2^(64 * p), so it takes p + 1 limbs).
+        multiplyLimbs(square, reciprocal, p, reciprocal, p);
+        square[2 * p] = 0;
+        shiftRight(square, 2 * p + 1, p * LIMB_BITS - 2);
+
+        //Newton step y = y + y * (1 - x * y^2) / 2, where 1 has a weight of 2^(128 * p - 2) in x * Y^2.
+        multiplyLimbs(product, radicand, p, square, p + 1);
+        for (u_int i = 0; i < 2 * p + 1; ++i) error[i] = 0;
+        error[2 * p - 1] = (u_int64_t) 1 << (LIMB_BITS - 2);
+        bool negative = subtractLimbs(error, product, 2 * p + 1);
+        if (negative) negateLimbs(error, 2 * p + 1);
+
+        //Lower part of the error is below the approximation precision and is skipped.
+        multiplyLimbs(correction, reciprocal, p, error + p, p + 1);
+        shiftRight(correction, 2 * p + 1, p * LIMB_BITS - 1);
+        if (negative) subtractLimbs(reciprocal, correction, p);
+        else addLimbs(reciprocal, correction, p);
+    }
+}
+
+bool LimbArray::absoluteDifference(u_int64_t *result, const u_int64_t *first, u_int firstSize,
+                                   const u_int64_t *second, u_int secondSize)
+{
+    //Second operand is zero extended to the size of first (secondSize <= firstSize).
+    int comparision = checkIfZero(first + secondSize, firstSize - secondSize) ? compare(first, second, secondSize) : 1;
+    if (comparision >= 0)
+    {
+        std::copy(first, first + firstSize, result);
+        bool borrow = subtractLimbs(result, second, secondSize);
+        subtractLimb(result + secondSize, firstSize - secondSize, borrow);
+        return false;
+    }
+    std::copy(second, second + secondSize, result);
+    for (u_int i = secondSize; i < firstSize; ++i) result[i] = 0;
+    subtractLimbs(result, first, secondSize);
+    return true;
+}
+
+bool LimbArray::divideLimbs(u_int64_t *quotient, u_int quotientSize, const u_int64_t *first,
+                            const u_int64_t *second, u_int size)
+{
+    //Reciprocal of divisor with one guard limb, Y = 2^(64 * size) / second * 2^(64 * (quotientSize + 1) - 2).
+    const u_int precision = quotientSize + 1;
+    ScratchArena::Frame frame;
+    u_int64_t *reciprocal = frame.allocate(precision);
+    reciprocalLimbs(reciprocal, precision, second, size);
+
+    //Quotient estimate Q = first * Y / 2^(64 * size + 63), it may differ from the exact quotient by a few units.
+    u_int64_t *product = frame.allocate(size + precision);
+    multiplyLimbs(product, first, size, reciprocal, precision);
+    shiftRight(product, size + precision, size * LIMB_BITS + LIMB_BITS - 1);
+    u_int64_t *estimate = frame.allocate(quotientSize + 1);
+    std::copy(product, product + quotientSize + 1, estimate);
+
+    //Remainder first * 2^(64 * quotientSize - 1) - Q * second (two's complement).
+    const u_int remainderSize = size + quotientSize + 1;
+    u_int64_t *remainder = frame.allocateZeroed(remainderSize);
+    u_int64_t *divisor = frame.allocateZeroed(remainderSize);
+    std::copy(first, first + size, remainder + quotientSize);
+    shiftRight(remainder, remainderSize, 1);
+    std::copy(second, second + size, divisor);
+    multiplyLimbs(product, estimate, quotientSize + 1, second, size);
+    subtractLimbs(remainder, product, remainderSize);
+
+    //Correct the estimate until 0 <= remainder < second.
+    while (remainder[remainderSize - 1] >> (LIMB_BITS - 1))
+    {
+        subtractLimb(estimate, quotientSize + 1, 1);
+        addLimbs(remainder, divisor, remainderSize);
+    }
+    while (compare(remainder, divisor, remainderSize) >= 0)
+    {
+        addLimb(estimate, quotientSize + 1, 1);
+        subtractLimbs(remainder, divisor, remainderSize);
+    }
+
+    std::copy(estimate, estimate + quotientSize, quotient);
+    return !checkIfZero(remainder, remainderSize);
+}
+
+bool LimbArray::squareRootLimbs(u_int64_t *root, const u_int64_t *first, u_int size)
+{
+    const u_int rootSize = size / 2;
+    u_int zeros = countLeadingZeros(first, size);
+    if (zeros == size * LIMB_BITS)
+    {
+        for (u_int i = 0; i < rootSize; ++i) root[i] = 0;
+        return false;
+    }
+
+    //Normalize radicand by an even shift, so that one of its two highest order bits is set.
+    u_int shift = zeros & ~1u;
+    ScratchArena::Frame frame;
+    u_int64_t *radicand = frame.allocate(size);
+    shiftLeft(radicand, first, size, shift);
+
+    //Reciprocal square root with one guard limb, Y = 1 / sqrt(radicand / 2^(64 * size)) * 2^(64 * (rootSize + 1) - 2).
+    const u_int precision = rootSize + 1;
+    u_int64_t *reciprocal = frame.allocate(precision);
+    reciprocalSquareRootLimbs(reciprocal, precision, radicand, size);
+
+    //Root estimate S = radicand * Y / 2^(64 * (rootSize + precision) - 2), undo normalization.
+    u_int64_t *product = frame.allocate(size + precision);
+    multiplyLimbs(product, radicand, size, reciprocal, precision);
+    shiftRight(product, size + precision, (rootSize + precision) * LIMB_BITS - 2 + shift / 2);
+    u_int64_t *estimate = frame.allocate(rootSize + 1);
+    std::copy(product, product + rootSize + 1, estimate);
+
+    //Remainder first - S^2 (two's complement).
+    const u_int remainderSize = size + 2;
+    u_int64_t *remainder = frame.allocateZeroed(remainderSize);
+    u_int64_t *step = frame.allocate(remainderSize);
+    std::copy(first, first + size, remainder);
+    multiplyLimbs(product, estimate, rootSize + 1, estimate, rootSize + 1);
+    subtractLimbs(remainder, product, remainderSize);
+
+    //Correct the estimate until 0 <= remainder < 2 * S + 1, where (S + 1)^2 - S^2 = 2 * S + 1.
+    auto computeStep = [&]()
+    {
+        for (u_int i = 0; i < remainderSize; ++i) step[i] = i <= rootSize ? estimate[i] : 0;
+        shiftLeft(step, remainderSize, 1);
+        addLimb(step, remainderSize, 1);
+    };
+    while (remainder[remainderSize - 1] >> (LIMB_BITS - 1))
+    {
+        subtractLimb(estimate, rootSize + 1, 1);
+        computeStep();
+        addLimbs(remainder, step, remainderSize);
+    }
+    for (computeStep(); compare(remainder, step, remainderSize) >= 0; computeStep())
+    {
+        subtractLimbs(remainder, step, remainderSize);
+        addLimb(estimate, rootSize + 1, 1);
+    }
+
+    std::copy(estimate, estimate + rootSize, root);
+    return !checkIfZero(remainder, remainderSize);
+}
+
+u_int LimbArray::countLeadingZeros(const u_int64_t *first, u_int size)
+{
+    for (int i = size - 1; i >= 0; --i)
+    {
+        if (first[i] != 0) return (size - 1 - i) * LIMB_BITS + __builtin_clzll(first[i]);
+    }
+    return size * LIMB_BITS;
+}
+
+bool LimbArray::roundNearestEven(u_int64_t *limbs, u_int size, u_int bits)
+{
+    if (bits == 0 || bits >= size * LIMB_BITS) return false;
+
+    //Position of the lowest order bit that is kept.
+    u_int position = size * LIMB_BITS - bits;
+    u_int roundPosition = position - 1;
+
+    bool rBit = (limbs[roundPosition / LIMB_BITS] >> (roundPosition % LIMB_BITS)) & 1;
+    bool sBit = (limbs[roundPosition / LIMB_BITS] & (((u_int64_t) 1 << (roundPosition % LIMB_BITS)) - 1)) != 0;
+    for (u_int i = 0; i < roundPosition / LIMB_BITS && !sBit; ++i)
+        sBit = limbs[i] != 0;
+    bool lastBit = (limbs[position / LIMB_BITS] >> (position % LIMB_BITS)) & 1;
+
+    //Clear bits that are not kept.
+    for (u_int i = 0; i < position / LIMB_BITS; ++i) limbs[i] = 0;
+    if (position % LIMB_BITS != 0) limbs[position / LIMB_BITS] &= ~(((u_int64_t) 1 << (position % LIMB_BITS)) - 1);
+
+    //R = 1 and S = 1 or R = 1, S = 0 and last kept bit is odd.
+    if (rBit && (sBit || lastBit))
+    {
+        return addLimb(limbs + position / LIMB_BITS, size - position / LIMB_BITS,
+                       (u_int64_t) 1 << (position % LIMB_BITS));
+    }
+    return false;
+}
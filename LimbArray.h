@@ -0,0 +1,429 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+
+class ThreadPool;
+
+/// Unsigned 128-bit integer used for intermediate limb products.
+typedef unsigned __int128 u_int128_t;
+
+/// Static class for variable precision 64-bit limb array manipulation.
+/// Limb arrays store unsigned integers with the least significant limb first.
+/// Limb addition, subtraction and multiply-accumulate use ADX/BMI2 carry chain kernels when the CPU has them.
+class LimbArray
+{
+public:
+    /// Bit count of a single limb.
+    static const u_int LIMB_BITS = 64;
+
+    /// Kernels used by limb addition, subtraction and multiply-accumulate.
+    enum class Kernel
+    {
+        Portable,
+        Adx
+    };
+
+    /// LimbArray static class default constructor.
+    LimbArray() = default;
+
+    /// Returns the best kernel supported by the CPU (ADX and BMI2 are required by the carry chain kernels).
+    /// \return Detected kernel.
+    static Kernel detectKernel();
+
+    /// Returns the kernel currently used by limb addition, subtraction and multiply-accumulate.
+    /// \return Selected kernel.
+    static Kernel getKernel() { return kernel; }
+
+    /// Selects the kernel used by limb addition, subtraction and multiply-accumulate
+    /// (limited to the ones supported by the CPU).
+    /// \param requested - requested kernel.
+    static void setKernel(Kernel requested);
+
+    /// Returns kernel name.
+    /// \param value - kernel.
+    /// \return Name of the kernel.
+    static const char *getKernelName(Kernel value);
+
+    /// Creates a limb container (at compile time if possible) which has bits 'lowBit' .. 'highBit' - 1 set.
+    /// \param lowBit - lowest order bit that should be set.
+    /// \param highBit - first bit after 'lowBit' that should not be set.
+    /// \return Limb container with requested bits set.
+    template<std::size_t size>
+    static constexpr std::array<u_int64_t, size> createMask(int lowBit, int highBit)
+    {
+        return createMask<size>(lowBit, highBit, std::make_index_sequence<size>());
+    }
+
+    /// Adds limbs from two containers of equal size together (result stored in first).
+    /// \param first - first addition operand.
+    /// \param second - second addition operand.
+    /// \param size - limb count of both operands.
+    /// \return 0 - if there is no carry, 1 - otherwise.
+    static bool addLimbs(u_int64_t *first, const u_int64_t *second, u_int size);
+
+    /// Adds a single limb to a container (result stored in first).
+    /// \param first - first addition operand.
+    /// \param size - limb count of first operand.
+    /// \param value - second addition operand.
+    /// \return 0 - if there is no carry, 1 - otherwise.
+    static bool addLimb(u_int64_t *first, u_int size, u_int64_t value);
+
+    /// Subtracts limbs from two containers of equal size (result stored in first).
+    /// \param first - first subtraction operand.
+    /// \param second - second subtraction operand.
+    /// \param size - limb count of both operands.
+    /// \return 0 - if there is no borrow, 1 - otherwise.
+    static bool subtractLimbs(u_int64_t *first, const u_int64_t *second, u_int size);
+
+    /// Subtracts a single limb from a container (result stored in first).
+    /// \param first - first subtraction operand.
+    /// \param size - limb count of first operand.
+    /// \param value - second subtraction operand.
+    /// \return 0 - if there is no borrow, 1 - otherwise.
+    static bool subtractLimb(u_int64_t *first, u_int size, u_int64_t value);
+
+    /// Compares two containers of equal size.
+    /// \param first - limb array for comparision.
+    /// \param second - limb array for comparision.
+    /// \param size - limb count of both arrays.
+    /// \return 0 if first and second argument is the same, -1 if second is greater and 1 if first is greater.
+    static int compare(const u_int64_t *first, const u_int64_t *second, u_int size);
+
+    /// Function that checks whether a limb container contains zero.
+    /// \param first - limb array to be checked.
+    /// \param size - limb count.
+    /// \return 1 - if zero, 0 - otherwise.
+    static bool checkIfZero(const u_int64_t *first, u_int size);
+
+    /// Negates a container (two's complement).
+    /// \param limbs - container to be negated.
+    /// \param size - limb count.
+    static void negateLimbs(u_int64_t *limbs, u_int size);
+
+    /// Shifts a limb container 'shift' bits left (towards higher order bits).
+    /// \param limbs - container which contents are going to be shifted.
+    /// \param size - limb count.
+    /// \param shift - bit shift count.
+    static void shiftLeft(u_int64_t *limbs, u_int size, u_int shift);
+
+    /// Copies a limb container shifted 'shift' bits left in a single pass.
+    /// \param destination - container for the shifted value, may be the same as source.
+    /// \param source - container which contents are going to be shifted.
+    /// \param size - limb count of both containers.
+    /// \param shift - bit shift count (any value, bits shifted past the container are lost).
+    static void shiftLeft(u_int64_t *destination, const u_int64_t *source, u_int size, u_int shift);
+
+    /// Shifts a limb container 'shift' bits right (towards lower order bits).
+    /// \param limbs - container which contents are going to be shifted.
+    /// \param size - limb count.
+    /// \param shift - bit shift count.
+    static void shiftRight(u_int64_t *limbs, u_int size, u_int shift);
+
+    /// Copies a limb container shifted 'shift' bits right in a single pass.
+    /// \param destination - container for the shifted value, may be the same as source.
+    /// \param source - container which contents are going to be shifted.
+    /// \param size - limb count of both containers.
+    /// \param shift - bit shift count (any value, bits shifted past the container are lost).
+    static void shiftRight(u_int64_t *destination, const u_int64_t *source, u_int size, u_int shift);
+
+    /// Shifts a limb container 'shift' bits right and reports whether any '1' bits were shifted out.
+    /// \param limbs - container which contents are going to be shifted.
+    /// \param size - limb count.
+    /// \param shift - bit shift count (any value, the container is cleared if it exceeds its size).
+    /// \return 1 - if any of the bits shifted out was set (sticky bit), 0 - otherwise.
+    static bool shiftRightSticky(u_int64_t *limbs, u_int size, u_int shift);
+
+    /// Multiplies a container by a single limb and adds the product to result (result += first * multiplier).
+    /// \param result - container the product is added to.
+    /// \param first - multiplication operand.
+    /// \param size - limb count of both containers.
+    /// \param multiplier - single limb multiplier.
+    /// \return Carry limb that did not fit in result.
+    static u_int64_t multiplyAddLimb(u_int64_t *result, const u_int64_t *first, u_int size, u_int64_t multiplier);
+
+    /// Operand limb count from which 'multiplyLimbs' switches from schoolbook to Karatsuba multiplication.
+    static u_int karatsubaThreshold;
+
+    /// Operand limb count from which 'multiplyLimbs' switches to number theoretic transform multiplication.
+    static u_int transformThreshold;
+
+    /// Operand limb count from which multiplication splits its work between threads of 'threadPool'.
+    static u_int parallelThreshold;
+
+    /// Pool used by multiplication above 'parallelThreshold' (nullptr - ThreadPool::global()).
+    static ThreadPool *threadPool;
+
+    /// Multiplies limbs from two containers together.
+    /// Schoolbook method is used for short operands, Karatsuba method above 'karatsubaThreshold' limbs
+    /// and exact number theoretic transform above 'transformThreshold' limbs (of the shorter operand).
+    /// Above 'parallelThreshold' limbs independent sub-products and transform butterflies run on 'threadPool'.
+    /// \param result - product container, 'firstSize' + 'secondSize' limbs, must not overlap operands.
+    /// \param first - first multiplication operand.
+    /// \param firstSize - limb count of first operand.
+    /// \param second - second multiplication operand.
+    /// \param secondSize - limb count of second operand.
+    static void multiplyLimbs(u_int64_t *result, const u_int64_t *first, u_int firstSize,
+                              const u_int64_t *second, u_int secondSize);
+
+    /// Divides two normalized containers (highest order bit set) of equal size.
+    /// Quotient is a fixed point number with highest order bit having a weight of 1.
+    /// Divisor reciprocal is computed with Newton-Raphson iteration, quotient is then corrected to be exact.
+    /// \param quotient - quotient container, must not overlap operands.
+    /// \param quotientSize - quotient limb count.
+    /// \param first - dividend.
+    /// \param second - divisor.
+    /// \param size - limb count of dividend and divisor.
+    /// \return 1 - if division was inexact (remainder is not zero), 0 - otherwise.
+    static bool divideLimbs(u_int64_t *quotient, u_int quotientSize, const u_int64_t *first,
+                            const u_int64_t *second, u_int size);
+
+    /// Computes an integer square root of a container.
+    /// Reciprocal square root is computed with Newton iteration, root is then corrected to be exact.
+    /// \param root - root container, 'size' / 2 limbs, must not overlap operand.
+    /// \param first - square root operation operand.
+    /// \param size - limb count of operand (even).
+    /// \return 1 - if square root was inexact (remainder is not zero), 0 - otherwise.
+    static bool squareRootLimbs(u_int64_t *root, const u_int64_t *first, u_int size);
+
+    /// Counts zero bits preceding the highest order '1' in a limb container.
+    /// \param first - container to count zeros in.
+    /// \param size - limb count.
+    /// \return Leading zero bit count ('size' * 64 if container is zero).
+    static u_int countLeadingZeros(const u_int64_t *first, u_int size);
+
+    /// Rounds a container to its 'bits' highest order bits using 'round to nearest even' method.
+    /// Lower order bits are cleared, sticky information must already be present in the lowest order bit.
+    /// \param limbs - container to be rounded.
+    /// \param size - limb count.
+    /// \param bits - number of bits to keep.
+    /// \return 1 - if rounding carried out of the container (which is left zeroed), 0 - otherwise.
+    static bool roundNearestEven(u_int64_t *limbs, u_int size, u_int bits);
+
+private:
+    static Kernel kernel;
+
+    /// Portable and ADX/BMI2 variants of 'addLimbs', 'subtractLimbs' and 'multiplyAddLimb'.
+    /// The ADX/BMI2 variants keep the carry in processor flags for the whole loop (adcx, sbb)
+    /// and run two independent carry chains (adcx, adox) next to mulx while multiplying.
+    static bool addLimbsPortable(u_int64_t *first, const u_int64_t *second, u_int size);
+
+    static bool subtractLimbsPortable(u_int64_t *first, const u_int64_t *second, u_int size);
+
+    static u_int64_t multiplyAddLimbPortable(u_int64_t *result, const u_int64_t *first, u_int size,
+                                             u_int64_t multiplier);
+
+    static bool addLimbsAdx(u_int64_t *first, const u_int64_t *second, u_int size);
+
+    static bool subtractLimbsAdx(u_int64_t *first, const u_int64_t *second, u_int size);
+
+    static u_int64_t multiplyAddLimbAdx(u_int64_t *result, const u_int64_t *first, u_int size, u_int64_t multiplier);
+
+    /// Prime modulus of the number theoretic transform (2^64 - 2^32 + 1).
+    static const u_int64_t TRANSFORM_PRIME = 0xFFFFFFFF00000001ull;
+
+    /// Primitive root modulo 'TRANSFORM_PRIME'.
+    static const u_int64_t TRANSFORM_GENERATOR = 7;
+
+    /// Bit count of a single transform digit.
+    static const u_int TRANSFORM_DIGIT_BITS = 16;
+
+    /// Length of transform ranges that are not split between threads.
+    static const std::size_t TRANSFORM_CHUNK = 8192;
+
+    /// Multiplies limbs from two containers together using schoolbook method.
+    /// \param result - product container, 'firstSize' + 'secondSize' limbs, must not overlap operands.
+    /// \param first - first multiplication operand.
+    /// \param firstSize - limb count of first operand.
+    /// \param second - second multiplication operand.
+    /// \param secondSize - limb count of second operand.
+    static void multiplySchoolbook(u_int64_t *result, const u_int64_t *first, u_int firstSize,
+                                   const u_int64_t *second, u_int secondSize);
+
+    /// Computes scratch limb count needed by 'multiplyKaratsuba' for operands of given size.
+    /// \param size - limb count of both operands.
+    /// \return Scratch limb count for all recursion levels.
+    static u_int karatsubaScratchSize(u_int size);
+
+    /// Product of two containers of equal size, computed by a single thread of parallel Karatsuba method.
+    struct Product
+    {
+        u_int64_t *result;
+        const u_int64_t *first;
+        const u_int64_t *second;
+        u_int size;
+    };
+
+    /// Returns the pool used by parallel multiplication.
+    /// \return 'threadPool' or the global pool.
+    static ThreadPool &getThreadPool();
+
+    /// Runs a job over indices 0 .. 'count' - 1 on the multiplication pool or serially on the calling thread.
+    /// The job is wrapped in a pool job only when it runs in parallel, so the serial path does not allocate.
+    /// \param parallel - 1 - use the multiplication pool, 0 - call 'job' once with the whole range.
+    /// \param count - index count.
+    /// \param chunk - length of ranges that are not split between threads.
+    /// \param job - body called with [begin, end) ranges.
+    template<typename Job>
+    static void runRanges(bool parallel, std::size_t count, std::size_t chunk, const Job &job)
+    {
+        if (parallel) runParallel(count, chunk, job);
+        else job(0, count);
+    }
+
+    /// Runs a job over indices 0 .. 'count' - 1 on the multiplication pool.
+    /// \param count - index count.
+    /// \param chunk - length of ranges that are not split between threads.
+    /// \param job - body called with [begin, end) ranges.
+    static void runParallel(std::size_t count, std::size_t chunk,
+                            const std::function<void(std::size_t, std::size_t)> &job);
+
+    /// Multiplies limbs from two containers of equal size together using Karatsuba method,
+    /// with sub-products of the top 'depth' recursion levels computed concurrently.
+    /// \param result - product container, 2 * 'size' limbs, must not overlap operands.
+    /// \param first - first multiplication operand.
+    /// \param second - second multiplication operand.
+    /// \param size - limb count of both operands.
+    /// \param depth - number of recursion levels expanded before sub-products are distributed.
+    static void multiplyKaratsubaParallel(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                          u_int size, u_int depth);
+
+    /// Computes scratch limb count needed by the top 'depth' levels of parallel Karatsuba method.
+    /// Sub-products of a level are all pending at once, so each of them needs its own scratch space.
+    /// \param size - limb count of both operands.
+    /// \param depth - expanded recursion level count.
+    /// \return Scratch limb count.
+    static u_int karatsubaParallelScratchSize(u_int size, u_int depth);
+
+    /// Expands the top 'depth' levels of Karatsuba method, computing operand differences
+    /// and collecting sub-products of the last level.
+    /// \param result - product container, 2 * 'size' limbs.
+    /// \param first - first multiplication operand.
+    /// \param second - second multiplication operand.
+    /// \param size - limb count of both operands.
+    /// \param scratch - 'karatsubaParallelScratchSize(size, depth)' limbs.
+    /// \param depth - levels left to expand.
+    /// \param products - collected sub-products, 3^'depth' entries.
+    /// \param count - number of sub-products collected so far.
+    static void splitKaratsuba(u_int64_t *result, const u_int64_t *first, const u_int64_t *second, u_int size,
+                               u_int64_t *scratch, u_int depth, Product *products, std::size_t &count);
+
+    /// Combines sub-products of levels expanded by 'splitKaratsuba', deepest levels first.
+    /// \param result - product container, 2 * 'size' limbs.
+    /// \param size - limb count of both operands.
+    /// \param scratch - scratch space passed to 'splitKaratsuba'.
+    /// \param depth - levels left to combine.
+    static void combineKaratsuba(u_int64_t *result, u_int size, u_int64_t *scratch, u_int depth);
+
+    /// Adds the middle Karatsuba term z1 * B^low = (z0 + z2 -/+ middle) * B^low to a result holding z0 and z2.
+    /// \param result - product container, 2 * ('low' + 'high') limbs, with z0 and z2 in place.
+    /// \param middle - product of operand half differences, 2 * 'high' limbs.
+    /// \param sum - temporary space, 2 * 'high' + 1 limbs.
+    /// \param low - limb count of low operand halves.
+    /// \param high - limb count of high operand halves.
+    /// \param negative - 1 - if the product of differences is negative.
+    static void addKaratsubaMiddle(u_int64_t *result, const u_int64_t *middle, u_int64_t *sum, u_int low, u_int high,
+                                   bool negative);
+
+    /// Multiplies limbs from two containers of equal size together using Karatsuba method.
+    /// \param result - product container, 2 * 'size' limbs, must not overlap operands.
+    /// \param first - first multiplication operand.
+    /// \param second - second multiplication operand.
+    /// \param size - limb count of both operands.
+    /// \param scratch - preallocated temporary space, 'karatsubaScratchSize(size)' limbs.
+    static void multiplyKaratsuba(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                  u_int size, u_int64_t *scratch);
+
+    /// Multiplies limbs from two containers together using number theoretic transform (exact).
+    /// \param result - product container, 'firstSize' + 'secondSize' limbs, must not overlap operands.
+    /// \param first - first multiplication operand.
+    /// \param firstSize - limb count of first operand.
+    /// \param second - second multiplication operand.
+    /// \param secondSize - limb count of second operand.
+    static void multiplyTransform(u_int64_t *result, const u_int64_t *first, u_int firstSize,
+                                  const u_int64_t *second, u_int secondSize);
+
+    /// Multiplies two values modulo 'TRANSFORM_PRIME'.
+    /// \param first - first multiplication operand (reduced).
+    /// \param second - second multiplication operand (reduced).
+    /// \return Reduced product.
+    static u_int64_t multiplyModular(u_int64_t first, u_int64_t second);
+
+    /// Raises a value to a power modulo 'TRANSFORM_PRIME'.
+    /// \param base - reduced base.
+    /// \param power - exponent.
+    /// \return Reduced power.
+    static u_int64_t powerModular(u_int64_t base, u_int64_t power);
+
+    /// Computes number theoretic transform of a sequence in place.
+    /// \param values - sequence of reduced values.
+    /// \param length - sequence length, must be a power of two.
+    /// \param inverse - 1 - inverse transform (scaled by 1 / length), 0 - forward transform.
+    /// \param parallel - 1 - butterflies of each stage are distributed between threads of the multiplication pool.
+    static void transform(u_int64_t *values, std::size_t length, bool inverse, bool parallel);
+
+    /// Computes limb counts used by consecutive Newton iteration steps.
+    /// \param precision - final limb count.
+    /// \param precisions - increasing limb counts, starting with 1 and ending with 'precision' (64 entries are enough).
+    /// \return Step count.
+    static u_int newtonPrecisions(u_int precision, u_int *precisions);
+
+    /// Copies 'resultSize' highest order limbs of a container (zero extended if it is shorter).
+    /// \param result - destination container.
+    /// \param resultSize - destination limb count.
+    /// \param first - source container.
+    /// \param size - source limb count.
+    static void truncateLimbs(u_int64_t *result, u_int resultSize, const u_int64_t *first, u_int size);
+
+    /// Computes reciprocal of a normalized container (highest order bit set) using Newton-Raphson iteration.
+    /// Result approximates 2^(64 * 'size') / 'first' * 2^(64 * 'precision' - 2) to a few units in the last place.
+    /// \param reciprocal - reciprocal container, 'precision' limbs.
+    /// \param precision - reciprocal limb count.
+    /// \param first - container to compute reciprocal of.
+    /// \param size - limb count of first.
+    static void reciprocalLimbs(u_int64_t *reciprocal, u_int precision, const u_int64_t *first, u_int size);
+
+    /// Computes reciprocal square root of a normalized container (one of two highest order bits set)
+    /// using Newton iteration.
+    /// Result approximates 1 / sqrt('first' / 2^(64 * 'size')) * 2^(64 * 'precision' - 2) to a few units in the last place.
+    /// \param reciprocal - reciprocal square root container, 'precision' limbs.
+    /// \param precision - reciprocal square root limb count.
+    /// \param first - container to compute reciprocal square root of.
+    /// \param size - limb count of first.
+    static void reciprocalSquareRootLimbs(u_int64_t *reciprocal, u_int precision, const u_int64_t *first, u_int size);
+
+    /// Computes absolute difference of two containers (secondSize <= firstSize).
+    /// \param result - difference container, 'firstSize' limbs.
+    /// \param first - first subtraction operand.
+    /// \param firstSize - limb count of first operand.
+    /// \param second - second subtraction operand (zero extended to 'firstSize').
+    /// \param secondSize - limb count of second operand.
+    /// \return 1 - if second operand is greater than first, 0 - otherwise.
+    static bool absoluteDifference(u_int64_t *result, const u_int64_t *first, u_int firstSize,
+                                   const u_int64_t *second, u_int secondSize);
+
+    /// Computes a single limb of a mask created by 'createMask'.
+    /// \param index - limb index in container.
+    /// \param lowBit - lowest order bit that should be set.
+    /// \param highBit - first bit after 'lowBit' that should not be set.
+    /// \return Mask limb at given index.
+    static constexpr u_int64_t createMaskLimb(std::size_t index, int lowBit, int highBit)
+    {
+        u_int64_t limb = 0;
+        for (int bit = 0; bit < (int) LIMB_BITS; ++bit)
+        {
+            int position = (int) index * (int) LIMB_BITS + bit;
+            if (position >= lowBit && position < highBit) limb |= (u_int64_t) 1 << bit;
+        }
+        return limb;
+    }
+
+    template<std::size_t size, std::size_t... indices>
+    static constexpr std::array<u_int64_t, size> createMask(int lowBit, int highBit, std::index_sequence<indices...>)
+    {
+        return std::array<u_int64_t, size>{{createMaskLimb(indices, lowBit, highBit)...}};
+    }
+};
@@ -0,0 +1,648 @@
+#include "LimbPlanes.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+LimbPlanes::Isa LimbPlanes::isa = LimbPlanes::detectIsa();
+
+LimbPlanes::Isa LimbPlanes::detectIsa()
+{
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Isa::Avx512;
+    if (__builtin_cpu_supports("avx2")) return Isa::Avx2;
+#endif
+    return Isa::Scalar;
+}
+
+void LimbPlanes::setIsa(Isa requested)
+{
+    Isa supported = detectIsa();
+    isa = static_cast<int>(requested) <= static_cast<int>(supported) ? requested : supported;
+}
+
+const char *LimbPlanes::getIsaName(Isa value)
+{
+    switch (value)
+    {
+        case Isa::Avx512:
+            return "AVX-512";
+        case Isa::Avx2:
+            return "AVX2";
+        default:
+            return "skalarne";
+    }
+}
+
+void LimbPlanes::addPlanes(u_int64_t *result, const u_int64_t *first, const u_int64_t *second, const u_int64_t *mask,
+                           u_int64_t *carry, u_int size, std::size_t stride, std::size_t count)
+{
+    std::size_t done = 0;
+    if (isa == Isa::Avx512) done = addAvx512(result, first, second, mask, carry, size, stride, count);
+    else if (isa == Isa::Avx2) done = addAvx2(result, first, second, mask, carry, size, stride, count);
+    addScalar(result, first, second, mask, carry, size, stride, done, count);
+}
+
+void LimbPlanes::subtractPlanes(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                u_int64_t *borrow, u_int size, std::size_t stride, std::size_t count)
+{
+    std::size_t done = 0;
+    if (isa == Isa::Avx512) done = subtractAvx512(result, first, second, borrow, size, stride, count);
+    else if (isa == Isa::Avx2) done = subtractAvx2(result, first, second, borrow, size, stride, count);
+    subtractScalar(result, first, second, borrow, size, stride, done, count);
+}
+
+void LimbPlanes::comparePlanes(signed char *result, const u_int64_t *first, const u_int64_t *second,
+                               u_int size, std::size_t stride, std::size_t count)
+{
+    std::size_t done = 0;
+    if (isa == Isa::Avx512) done = compareAvx512(result, first, second, size, stride, count);
+    else if (isa == Isa::Avx2) done = compareAvx2(result, first, second, size, stride, count);
+    compareScalar(result, first, second, size, stride, done, count);
+}
+
+void LimbPlanes::shiftRightSticky(u_int64_t *planes, const u_int64_t *shift, u_int64_t *sticky, u_int size,
+                                  std::size_t stride, std::size_t count)
+{
+    std::size_t done = 0;
+    if (isa == Isa::Avx512) done = shiftRightStickyAvx512(planes, shift, sticky, size, stride, count);
+    else if (isa == Isa::Avx2) done = shiftRightStickyAvx2(planes, shift, sticky, size, stride, count);
+    shiftRightStickyScalar(planes, shift, sticky, size, stride, done, count);
+}
+
+void LimbPlanes::shiftLeft(u_int64_t *planes, const u_int64_t *shift, u_int size, std::size_t stride,
+                           std::size_t count)
+{
+    std::size_t done = 0;
+    if (isa == Isa::Avx512) done = shiftLeftAvx512(planes, shift, size, stride, count);
+    else if (isa == Isa::Avx2) done = shiftLeftAvx2(planes, shift, size, stride, count);
+    shiftLeftScalar(planes, shift, size, stride, done, count);
+}
+
+void LimbPlanes::countLeadingZeros(u_int64_t *zeros, const u_int64_t *planes, u_int size, std::size_t stride,
+                                   std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) zeros[i] = 0;
+
+    //Lanes count whole zero limbs until their highest nonzero limb is found.
+    u_int64_t undecided = ~(u_int64_t) 0;
+    for (u_int j = size; j-- > 0 && undecided != 0;)
+    {
+        const u_int64_t *limbs = planes + j * stride;
+        undecided = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (zeros[i] != (u_int64_t) (size - 1 - j) * 64) continue;
+            zeros[i] += limbs[i] == 0 ? 64 : __builtin_clzll(limbs[i]);
+            undecided |= limbs[i] == 0;
+        }
+    }
+}
+
+void LimbPlanes::shiftRightStickyScalar(u_int64_t *planes, const u_int64_t *shift, u_int64_t *sticky, u_int size,
+                                        std::size_t stride, std::size_t begin, std::size_t count)
+{
+    for (std::size_t i = begin; i < count; ++i) sticky[i] = 0;
+
+    //Limbs are visited in order for all lanes, a source limb is never below its destination,
+    //so every lane can be shifted in place starting from the lowest limb.
+    for (u_int j = 0; j < size; ++j)
+    {
+        u_int64_t *limbs = planes + j * stride;
+        for (std::size_t i = begin; i < count; ++i)
+        {
+            u_int limbShift = (u_int) (shift[i] / 64);
+            u_int bitShift = (u_int) (shift[i] % 64);
+            u_int source = j + limbShift;
+
+            if (j < limbShift) sticky[i] |= limbs[i] != 0;
+            else if (j == limbShift) sticky[i] |= (limbs[i] << (63 - bitShift) << 1) != 0;
+
+            u_int64_t low = source < size ? planes[source * stride + i] : 0;
+            u_int64_t high = source + 1 < size ? planes[(source + 1) * stride + i] : 0;
+            limbs[i] = (low >> bitShift) | (high << (63 - bitShift) << 1);
+        }
+    }
+}
+
+void LimbPlanes::shiftLeftScalar(u_int64_t *planes, const u_int64_t *shift, u_int size, std::size_t stride,
+                                 std::size_t begin, std::size_t count)
+{
+    //Source limbs are never above the destination, lanes are shifted in place starting from the highest limb.
+    for (u_int j = size; j-- > 0;)
+    {
+        u_int64_t *limbs = planes + j * stride;
+        for (std::size_t i = begin; i < count; ++i)
+        {
+            u_int limbShift = (u_int) (shift[i] / 64);
+            u_int bitShift = (u_int) (shift[i] % 64);
+
+            u_int64_t high = j >= limbShift ? planes[(j - limbShift) * stride + i] : 0;
+            u_int64_t low = j >= limbShift + 1 ? planes[(j - limbShift - 1) * stride + i] : 0;
+            limbs[i] = (high << bitShift) | (low >> (63 - bitShift) >> 1);
+        }
+    }
+}
+
+void LimbPlanes::addScalar(u_int64_t *result, const u_int64_t *first, const u_int64_t *second, const u_int64_t *mask,
+                           u_int64_t *carry, u_int size, std::size_t stride, std::size_t begin, std::size_t count)
+{
+    for (u_int j = 0; j < size; ++j)
+    {
+        for (std::size_t i = begin; i < count; ++i)
+        {
+            std::size_t k = j * stride + i;
+            u_int64_t a = first[k];
+            u_int64_t b = mask ? second[k] ^ mask[i] : second[k];
+            u_int64_t sum = a + b;
+            u_int64_t total = sum + carry[i];
+            carry[i] = (sum < a) | (total < sum);
+            result[k] = total;
+        }
+    }
+}
+
+void LimbPlanes::subtractScalar(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                u_int64_t *borrow, u_int size, std::size_t stride, std::size_t begin,
+                                std::size_t count)
+{
+    for (u_int j = 0; j < size; ++j)
+    {
+        for (std::size_t i = begin; i < count; ++i)
+        {
+            std::size_t k = j * stride + i;
+            u_int64_t a = first[k];
+            u_int64_t b = second[k];
+            u_int64_t difference = a - b;
+            result[k] = difference - borrow[i];
+            borrow[i] = (a < b) | (difference < borrow[i]);
+        }
+    }
+}
+
+void LimbPlanes::compareScalar(signed char *result, const u_int64_t *first, const u_int64_t *second,
+                               u_int size, std::size_t stride, std::size_t begin, std::size_t count)
+{
+    for (std::size_t i = begin; i < count; ++i)
+    {
+        signed char order = 0;
+        for (u_int j = size; j-- > 0 && order == 0;)
+        {
+            std::size_t k = j * stride + i;
+            if (first[k] > second[k]) order = 1;
+            else if (first[k] < second[k]) order = -1;
+        }
+        result[i] = order;
+    }
+}
+
+#ifdef __x86_64__
+
+namespace
+{
+    //Independent vectors processed together, so that carry chains of different lanes overlap in time.
+    const int AVX2_VECTORS = 4;
+    const int AVX512_VECTORS = 2;
+
+    //AVX2 has only signed 64-bit comparision, unsigned order is obtained by flipping the sign bits.
+    __attribute__((target("avx2")))
+    inline __m256i lessUnsigned(__m256i first, __m256i second)
+    {
+        const __m256i signBit = _mm256_set1_epi64x((long long) 1 << 63);
+        return _mm256_cmpgt_epi64(_mm256_xor_si256(second, signBit), _mm256_xor_si256(first, signBit));
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i load(const u_int64_t *source)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source));
+    }
+
+    __attribute__((target("avx2")))
+    inline void store(u_int64_t *destination, __m256i value)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination), value);
+    }
+}
+
+__attribute__((target("avx2")))
+std::size_t LimbPlanes::addAvx2(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                const u_int64_t *mask, u_int64_t *carry, u_int size, std::size_t stride,
+                                std::size_t count)
+{
+    const std::size_t block = 4 * AVX2_VECTORS;
+    std::size_t i = 0;
+    for (; i + block <= count; i += block)
+    {
+        __m256i carries[AVX2_VECTORS], masks[AVX2_VECTORS];
+        for (int v = 0; v < AVX2_VECTORS; ++v)
+        {
+            carries[v] = load(carry + i + 4 * v);
+            masks[v] = mask ? load(mask + i + 4 * v) : _mm256_setzero_si256();
+        }
+
+        for (u_int j = 0; j < size; ++j)
+        {
+            for (int v = 0; v < AVX2_VECTORS; ++v)
+            {
+                std::size_t k = j * stride + i + 4 * v;
+                __m256i a = load(first + k);
+                __m256i sum = _mm256_add_epi64(a, _mm256_xor_si256(load(second + k), masks[v]));
+                __m256i total = _mm256_add_epi64(sum, carries[v]);
+                __m256i overflow = _mm256_or_si256(lessUnsigned(sum, a), lessUnsigned(total, sum));
+                carries[v] = _mm256_srli_epi64(overflow, 63);
+                store(result + k, total);
+            }
+        }
+
+        for (int v = 0; v < AVX2_VECTORS; ++v) store(carry + i + 4 * v, carries[v]);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+std::size_t LimbPlanes::subtractAvx2(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                     u_int64_t *borrow, u_int size, std::size_t stride, std::size_t count)
+{
+    const std::size_t block = 4 * AVX2_VECTORS;
+    std::size_t i = 0;
+    for (; i + block <= count; i += block)
+    {
+        __m256i borrows[AVX2_VECTORS];
+        for (int v = 0; v < AVX2_VECTORS; ++v) borrows[v] = load(borrow + i + 4 * v);
+
+        for (u_int j = 0; j < size; ++j)
+        {
+            for (int v = 0; v < AVX2_VECTORS; ++v)
+            {
+                std::size_t k = j * stride + i + 4 * v;
+                __m256i a = load(first + k);
+                __m256i b = load(second + k);
+                __m256i difference = _mm256_sub_epi64(a, b);
+                __m256i underflow = _mm256_or_si256(lessUnsigned(a, b), lessUnsigned(difference, borrows[v]));
+                store(result + k, _mm256_sub_epi64(difference, borrows[v]));
+                borrows[v] = _mm256_srli_epi64(underflow, 63);
+            }
+        }
+
+        for (int v = 0; v < AVX2_VECTORS; ++v) store(borrow + i + 4 * v, borrows[v]);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+std::size_t LimbPlanes::compareAvx2(signed char *result, const u_int64_t *first, const u_int64_t *second,
+                                    u_int size, std::size_t stride, std::size_t count)
+{
+    const __m256i one = _mm256_set1_epi64x(1);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i order = _mm256_setzero_si256();
+        __m256i undecided = _mm256_set1_epi64x(-1);
+
+        //Lanes are decided by their highest differing limb, the loop ends once every lane is decided.
+        for (u_int j = size; j-- > 0 && !_mm256_testz_si256(undecided, undecided);)
+        {
+            __m256i a = load(first + j * stride + i);
+            __m256i b = load(second + j * stride + i);
+            __m256i greater = lessUnsigned(b, a);
+            __m256i lower = lessUnsigned(a, b);
+            __m256i sign = _mm256_or_si256(_mm256_and_si256(greater, one), lower);
+            order = _mm256_or_si256(order, _mm256_and_si256(undecided, sign));
+            undecided = _mm256_andnot_si256(_mm256_or_si256(greater, lower), undecided);
+        }
+
+        alignas(32) long long orders[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(orders), order);
+        for (int l = 0; l < 4; ++l) result[i + l] = (signed char) orders[l];
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+std::size_t LimbPlanes::addAvx512(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                  const u_int64_t *mask, u_int64_t *carry, u_int size, std::size_t stride,
+                                  std::size_t count)
+{
+    const __m512i one = _mm512_set1_epi64(1);
+    const std::size_t block = 8 * AVX512_VECTORS;
+    std::size_t i = 0;
+    for (; i + block <= count; i += block)
+    {
+        __mmask8 carries[AVX512_VECTORS];
+        __m512i masks[AVX512_VECTORS];
+        for (int v = 0; v < AVX512_VECTORS; ++v)
+        {
+            carries[v] = _mm512_test_epi64_mask(_mm512_loadu_si512(carry + i + 8 * v), one);
+            masks[v] = mask ? _mm512_loadu_si512(mask + i + 8 * v) : _mm512_setzero_si512();
+        }
+
+        for (u_int j = 0; j < size; ++j)
+        {
+            for (int v = 0; v < AVX512_VECTORS; ++v)
+            {
+                std::size_t k = j * stride + i + 8 * v;
+                __m512i a = _mm512_loadu_si512(first + k);
+                __m512i sum = _mm512_add_epi64(a, _mm512_xor_si512(_mm512_loadu_si512(second + k), masks[v]));
+                __m512i total = _mm512_mask_add_epi64(sum, carries[v], sum, one);
+                carries[v] = _mm512_cmplt_epu64_mask(sum, a) | _mm512_cmplt_epu64_mask(total, sum);
+                _mm512_storeu_si512(result + k, total);
+            }
+        }
+
+        for (int v = 0; v < AVX512_VECTORS; ++v)
+            _mm512_storeu_si512(carry + i + 8 * v, _mm512_maskz_mov_epi64(carries[v], one));
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+std::size_t LimbPlanes::subtractAvx512(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                       u_int64_t *borrow, u_int size, std::size_t stride, std::size_t count)
+{
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m512i zero = _mm512_setzero_si512();
+    const std::size_t block = 8 * AVX512_VECTORS;
+    std::size_t i = 0;
+    for (; i + block <= count; i += block)
+    {
+        __mmask8 borrows[AVX512_VECTORS];
+        for (int v = 0; v < AVX512_VECTORS; ++v)
+            borrows[v] = _mm512_test_epi64_mask(_mm512_loadu_si512(borrow + i + 8 * v), one);
+
+        for (u_int j = 0; j < size; ++j)
+        {
+            for (int v = 0; v < AVX512_VECTORS; ++v)
+            {
+                std::size_t k = j * stride + i + 8 * v;
+                __m512i a = _mm512_loadu_si512(first + k);
+                __m512i b = _mm512_loadu_si512(second + k);
+                __m512i difference = _mm512_sub_epi64(a, b);
+                _mm512_storeu_si512(result + k, _mm512_mask_sub_epi64(difference, borrows[v], difference, one));
+                borrows[v] = _mm512_cmplt_epu64_mask(a, b) |
+                             _mm512_mask_cmpeq_epu64_mask(borrows[v], difference, zero);
+            }
+        }
+
+        for (int v = 0; v < AVX512_VECTORS; ++v)
+            _mm512_storeu_si512(borrow + i + 8 * v, _mm512_maskz_mov_epi64(borrows[v], one));
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+std::size_t LimbPlanes::compareAvx512(signed char *result, const u_int64_t *first, const u_int64_t *second,
+                                      u_int size, std::size_t stride, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __mmask8 greater = 0, lower = 0, decided = 0;
+
+        //Lanes are decided by their highest differing limb, the loop ends once every lane is decided.
+        for (u_int j = size; j-- > 0 && decided != 0xff;)
+        {
+            __m512i a = _mm512_loadu_si512(first + j * stride + i);
+            __m512i b = _mm512_loadu_si512(second + j * stride + i);
+            greater |= _mm512_mask_cmpgt_epu64_mask((__mmask8) ~decided, a, b);
+            lower |= _mm512_mask_cmplt_epu64_mask((__mmask8) ~decided, a, b);
+            decided = greater | lower;
+        }
+
+        __m512i order = _mm512_maskz_set1_epi64(greater, 1);
+        order = _mm512_mask_set1_epi64(order, lower, -1);
+        __m128i bytes = _mm512_mask_cvtepi64_epi8(_mm_setzero_si128(), 0xff, order);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(result + i), bytes);
+    }
+    return i;
+}
+
+//Vector shifts handle lanes of a vector which share the limb part of their shift lengths (usually all of them
+//for aligned operands), other vectors are shifted lane by lane. Per lane shifts of 64 bits give zero.
+
+__attribute__((target("avx2")))
+std::size_t LimbPlanes::shiftRightStickyAvx2(u_int64_t *planes, const u_int64_t *shift, u_int64_t *sticky,
+                                             u_int size, std::size_t stride, std::size_t count)
+{
+    const __m256i bits = _mm256_set1_epi64x(64);
+    const __m256i low = _mm256_set1_epi64x(63);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i lengths = load(shift + i);
+        if (_mm256_testz_si256(lengths, lengths))
+        {
+            store(sticky + i, _mm256_setzero_si256());
+            continue;
+        }
+
+        __m256i limbShifts = _mm256_srli_epi64(lengths, 6);
+        u_int limbShift = (u_int) (shift[i] / 64);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(limbShifts, _mm256_set1_epi64x(limbShift))) != -1)
+        {
+            shiftRightStickyScalar(planes, shift, sticky, size, stride, i, i + 4);
+            continue;
+        }
+
+        __m256i right = _mm256_and_si256(lengths, low);
+        __m256i left = _mm256_sub_epi64(bits, right);
+        __m256i lost = _mm256_setzero_si256();
+        for (u_int j = 0; j < limbShift && j < size; ++j)
+            lost = _mm256_or_si256(lost, load(planes + j * stride + i));
+        if (limbShift < size)
+            lost = _mm256_or_si256(lost, _mm256_sllv_epi64(load(planes + limbShift * stride + i), left));
+
+        for (u_int j = 0; j < size; ++j)
+        {
+            u_int source = j + limbShift;
+            __m256i lowLimb = source < size ? load(planes + source * stride + i) : _mm256_setzero_si256();
+            __m256i highLimb = source + 1 < size ? load(planes + (source + 1) * stride + i) : _mm256_setzero_si256();
+            store(planes + j * stride + i,
+                  _mm256_or_si256(_mm256_srlv_epi64(lowLimb, right), _mm256_sllv_epi64(highLimb, left)));
+        }
+
+        __m256i zero = _mm256_cmpeq_epi64(lost, _mm256_setzero_si256());
+        store(sticky + i, _mm256_andnot_si256(zero, _mm256_set1_epi64x(1)));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+std::size_t LimbPlanes::shiftLeftAvx2(u_int64_t *planes, const u_int64_t *shift, u_int size, std::size_t stride,
+                                      std::size_t count)
+{
+    const __m256i bits = _mm256_set1_epi64x(64);
+    const __m256i low = _mm256_set1_epi64x(63);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i lengths = load(shift + i);
+        if (_mm256_testz_si256(lengths, lengths)) continue;
+
+        __m256i limbShifts = _mm256_srli_epi64(lengths, 6);
+        u_int limbShift = (u_int) (shift[i] / 64);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(limbShifts, _mm256_set1_epi64x(limbShift))) != -1)
+        {
+            shiftLeftScalar(planes, shift, size, stride, i, i + 4);
+            continue;
+        }
+
+        __m256i left = _mm256_and_si256(lengths, low);
+        __m256i right = _mm256_sub_epi64(bits, left);
+        for (u_int j = size; j-- > 0;)
+        {
+            __m256i highLimb = j >= limbShift ? load(planes + (j - limbShift) * stride + i) : _mm256_setzero_si256();
+            __m256i lowLimb = j >= limbShift + 1 ? load(planes + (j - limbShift - 1) * stride + i)
+                                                 : _mm256_setzero_si256();
+            store(planes + j * stride + i,
+                  _mm256_or_si256(_mm256_sllv_epi64(highLimb, left), _mm256_srlv_epi64(lowLimb, right)));
+        }
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+std::size_t LimbPlanes::shiftRightStickyAvx512(u_int64_t *planes, const u_int64_t *shift, u_int64_t *sticky,
+                                               u_int size, std::size_t stride, std::size_t count)
+{
+    const __m512i bits = _mm512_set1_epi64(64);
+    const __m512i low = _mm512_set1_epi64(63);
+    const __m512i one = _mm512_set1_epi64(1);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512i lengths = _mm512_loadu_si512(shift + i);
+        if (_mm512_test_epi64_mask(lengths, lengths) == 0)
+        {
+            _mm512_storeu_si512(sticky + i, _mm512_setzero_si512());
+            continue;
+        }
+
+        u_int limbShift = (u_int) (shift[i] / 64);
+        if (_mm512_cmpneq_epu64_mask(_mm512_srli_epi64(lengths, 6), _mm512_set1_epi64(limbShift)) != 0)
+        {
+            shiftRightStickyScalar(planes, shift, sticky, size, stride, i, i + 8);
+            continue;
+        }
+
+        __m512i right = _mm512_and_si512(lengths, low);
+        __m512i left = _mm512_sub_epi64(bits, right);
+        __m512i lost = _mm512_setzero_si512();
+        for (u_int j = 0; j < limbShift && j < size; ++j)
+            lost = _mm512_or_si512(lost, _mm512_loadu_si512(planes + j * stride + i));
+        if (limbShift < size)
+            lost = _mm512_or_si512(lost, _mm512_sllv_epi64(_mm512_loadu_si512(planes + limbShift * stride + i), left));
+
+        for (u_int j = 0; j < size; ++j)
+        {
+            u_int source = j + limbShift;
+            __m512i lowLimb = source < size ? _mm512_loadu_si512(planes + source * stride + i)
+                                            : _mm512_setzero_si512();
+            __m512i highLimb = source + 1 < size ? _mm512_loadu_si512(planes + (source + 1) * stride + i)
+                                                 : _mm512_setzero_si512();
+            _mm512_storeu_si512(planes + j * stride + i,
+                                _mm512_or_si512(_mm512_srlv_epi64(lowLimb, right), _mm512_sllv_epi64(highLimb, left)));
+        }
+
+        _mm512_storeu_si512(sticky + i, _mm512_maskz_mov_epi64(_mm512_test_epi64_mask(lost, lost), one));
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+std::size_t LimbPlanes::shiftLeftAvx512(u_int64_t *planes, const u_int64_t *shift, u_int size, std::size_t stride,
+                                        std::size_t count)
+{
+    const __m512i bits = _mm512_set1_epi64(64);
+    const __m512i low = _mm512_set1_epi64(63);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m512i lengths = _mm512_loadu_si512(shift + i);
+        if (_mm512_test_epi64_mask(lengths, lengths) == 0) continue;
+
+        u_int limbShift = (u_int) (shift[i] / 64);
+        if (_mm512_cmpneq_epu64_mask(_mm512_srli_epi64(lengths, 6), _mm512_set1_epi64(limbShift)) != 0)
+        {
+            shiftLeftScalar(planes, shift, size, stride, i, i + 8);
+            continue;
+        }
+
+        __m512i left = _mm512_and_si512(lengths, low);
+        __m512i right = _mm512_sub_epi64(bits, left);
+        for (u_int j = size; j-- > 0;)
+        {
+            __m512i highLimb = j >= limbShift ? _mm512_loadu_si512(planes + (j - limbShift) * stride + i)
+                                              : _mm512_setzero_si512();
+            __m512i lowLimb = j >= limbShift + 1 ? _mm512_loadu_si512(planes + (j - limbShift - 1) * stride + i)
+                                                 : _mm512_setzero_si512();
+            _mm512_storeu_si512(planes + j * stride + i,
+                                _mm512_or_si512(_mm512_sllv_epi64(highLimb, left), _mm512_srlv_epi64(lowLimb, right)));
+        }
+    }
+    return i;
+}
+
+#else
+
+std::size_t LimbPlanes::addAvx2(u_int64_t *, const u_int64_t *, const u_int64_t *, const u_int64_t *, u_int64_t *,
+                                u_int, std::size_t, std::size_t)
+{
+    return 0;
+}
+
+std::size_t LimbPlanes::subtractAvx2(u_int64_t *, const u_int64_t *, const u_int64_t *, u_int64_t *, u_int,
+                                     std::size_t, std::size_t)
+{
+    return 0;
+}
+
+std::size_t LimbPlanes::compareAvx2(signed char *, const u_int64_t *, const u_int64_t *, u_int, std::size_t,
+                                    std::size_t)
+{
+    return 0;
+}
+
+std::size_t LimbPlanes::addAvx512(u_int64_t *, const u_int64_t *, const u_int64_t *, const u_int64_t *, u_int64_t *,
+                                  u_int, std::size_t, std::size_t)
+{
+    return 0;
+}
+
+std::size_t LimbPlanes::subtractAvx512(u_int64_t *, const u_int64_t *, const u_int64_t *, u_int64_t *, u_int,
+                                       std::size_t, std::size_t)
+{
+    return 0;
+}
+
+std::size_t LimbPlanes::compareAvx512(signed char *, const u_int64_t *, const u_int64_t *, u_int, std::size_t,
+                                      std::size_t)
+{
+    return 0;
+}
+
+std::size_t LimbPlanes::shiftRightStickyAvx2(u_int64_t *, const u_int64_t *, u_int64_t *, u_int, std::size_t,
+                                             std::size_t)
+{
+    return 0;
+}
+
+std::size_t LimbPlanes::shiftLeftAvx2(u_int64_t *, const u_int64_t *, u_int, std::size_t, std::size_t)
+{
+    return 0;
+}
+
+std::size_t LimbPlanes::shiftRightStickyAvx512(u_int64_t *, const u_int64_t *, u_int64_t *, u_int, std::size_t,
+                                               std::size_t)
+{
+    return 0;
+}
+
+std::size_t LimbPlanes::shiftLeftAvx512(u_int64_t *, const u_int64_t *, u_int, std::size_t, std::size_t)
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <sys/types.h>
+
+/// Static class for elementwise operations on limb planes, one number per lane.
+/// A plane set stores limb 'j' of lane 'i' at [j * stride + i] (the layout of VariableFloatArray),
+/// so the same limb of neighbouring numbers can be processed with a single vector instruction.
+/// Vector kernels (AVX2, AVX-512) are selected at startup from CPU features, scalar kernels are the fallback.
+class LimbPlanes
+{
+public:
+    /// Instruction set used by the kernels.
+    enum class Isa
+    {
+        Scalar,
+        Avx2,
+        Avx512
+    };
+
+    /// LimbPlanes static class default constructor.
+    LimbPlanes() = default;
+
+    /// Returns the best instruction set supported by the CPU.
+    /// \return Detected instruction set.
+    static Isa detectIsa();
+
+    /// Returns the instruction set currently used by the kernels.
+    /// \return Selected instruction set.
+    static Isa getIsa() { return isa; }
+
+    /// Selects the instruction set used by the kernels (limited to the ones supported by the CPU).
+    /// \param requested - requested instruction set.
+    static void setIsa(Isa requested);
+
+    /// Returns instruction set name.
+    /// \param value - instruction set.
+    /// \return Name of the instruction set.
+    static const char *getIsaName(Isa value);
+
+    /// Adds planes lane by lane: result = first + (second XOR mask) + carry.
+    /// With mask of ones and carry 1 a lane computes first - second.
+    /// \param result - result planes (may be the same as any operand).
+    /// \param first - first operand planes.
+    /// \param second - second operand planes.
+    /// \param mask - per lane mask applied to every limb of 'second', nullptr if zero.
+    /// \param carry - per lane incoming carry (0 or 1), replaced with the outgoing carry.
+    /// \param size - limb count of every lane.
+    /// \param stride - distance between neighbouring limbs of a lane.
+    /// \param count - lane count.
+    static void addPlanes(u_int64_t *result, const u_int64_t *first, const u_int64_t *second, const u_int64_t *mask,
+                          u_int64_t *carry, u_int size, std::size_t stride, std::size_t count);
+
+    /// Subtracts planes lane by lane: result = first - second - borrow.
+    /// \param result - result planes (may be the same as any operand).
+    /// \param first - first operand planes.
+    /// \param second - second operand planes.
+    /// \param borrow - per lane incoming borrow (0 or 1), replaced with the outgoing borrow.
+    /// \param size - limb count of every lane.
+    /// \param stride - distance between neighbouring limbs of a lane.
+    /// \param count - lane count.
+    static void subtractPlanes(u_int64_t *result, const u_int64_t *first, const u_int64_t *second, u_int64_t *borrow,
+                               u_int size, std::size_t stride, std::size_t count);
+
+    /// Compares planes lane by lane.
+    /// \param result - per lane result: 1 - first is bigger, -1 - second is bigger, 0 - equal.
+    /// \param first - first operand planes.
+    /// \param second - second operand planes.
+    /// \param size - limb count of every lane.
+    /// \param stride - distance between neighbouring limbs of a lane.
+    /// \param count - lane count.
+    static void comparePlanes(signed char *result, const u_int64_t *first, const u_int64_t *second,
+                              u_int size, std::size_t stride, std::size_t count);
+
+    /// Shifts every lane right by its own length, bits shifted out are kept as sticky flags.
+    /// \param planes - planes to be shifted in place.
+    /// \param shift - per lane shift length in bits (at most size * 64).
+    /// \param sticky - per lane result: 1 if any bit that was set has been shifted out, 0 otherwise.
+    /// \param size - limb count of every lane.
+    /// \param stride - distance between neighbouring limbs of a lane.
+    /// \param count - lane count.
+    static void shiftRightSticky(u_int64_t *planes, const u_int64_t *shift, u_int64_t *sticky, u_int size,
+                                 std::size_t stride, std::size_t count);
+
+    /// Shifts every lane left by its own length.
+    /// \param planes - planes to be shifted in place.
+    /// \param shift - per lane shift length in bits (lower than size * 64).
+    /// \param size - limb count of every lane.
+    /// \param stride - distance between neighbouring limbs of a lane.
+    /// \param count - lane count.
+    static void shiftLeft(u_int64_t *planes, const u_int64_t *shift, u_int size, std::size_t stride,
+                          std::size_t count);
+
+    /// Counts leading zero bits of every lane.
+    /// \param zeros - per lane result (size * 64 for a lane of zeros).
+    /// \param planes - planes to be examined.
+    /// \param size - limb count of every lane.
+    /// \param stride - distance between neighbouring limbs of a lane.
+    /// \param count - lane count.
+    static void countLeadingZeros(u_int64_t *zeros, const u_int64_t *planes, u_int size, std::size_t stride,
+                                  std::size_t count);
+
+private:
+    static Isa isa;
+
+    static void addScalar(u_int64_t *result, const u_int64_t *first, const u_int64_t *second, const u_int64_t *mask,
+                          u_int64_t *carry, u_int size, std::size_t stride, std::size_t begin, std::size_t count);
+
+    static void subtractScalar(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                               u_int64_t *borrow, u_int size, std::size_t stride, std::size_t begin,
+                               std::size_t count);
+
+    static void compareScalar(signed char *result, const u_int64_t *first, const u_int64_t *second,
+                              u_int size, std::size_t stride, std::size_t begin, std::size_t count);
+
+    static void shiftRightStickyScalar(u_int64_t *planes, const u_int64_t *shift, u_int64_t *sticky, u_int size,
+                                       std::size_t stride, std::size_t begin, std::size_t count);
+
+    static void shiftLeftScalar(u_int64_t *planes, const u_int64_t *shift, u_int size, std::size_t stride,
+                                std::size_t begin, std::size_t count);
+
+    /// Vector kernels process lanes in whole vectors and return the number of processed lanes.
+    static std::size_t addAvx2(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                               const u_int64_t *mask, u_int64_t *carry, u_int size, std::size_t stride,
+                               std::size_t count);
+
+    static std::size_t subtractAvx2(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                    u_int64_t *borrow, u_int size, std::size_t stride, std::size_t count);
+
+    static std::size_t compareAvx2(signed char *result, const u_int64_t *first, const u_int64_t *second,
+                                   u_int size, std::size_t stride, std::size_t count);
+
+    static std::size_t shiftRightStickyAvx2(u_int64_t *planes, const u_int64_t *shift, u_int64_t *sticky,
+                                            u_int size, std::size_t stride, std::size_t count);
+
+    static std::size_t shiftLeftAvx2(u_int64_t *planes, const u_int64_t *shift, u_int size, std::size_t stride,
+                                     std::size_t count);
+
+    static std::size_t addAvx512(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                 const u_int64_t *mask, u_int64_t *carry, u_int size, std::size_t stride,
+                                 std::size_t count);
+
+    static std::size_t subtractAvx512(u_int64_t *result, const u_int64_t *first, const u_int64_t *second,
+                                      u_int64_t *borrow, u_int size, std::size_t stride, std::size_t count);
+
+    static std::size_t compareAvx512(signed char *result, const u_int64_t *first, const u_int64_t *second,
+                                     u_int size, std::size_t stride, std::size_t count);
+
+    static std::size_t shiftRightStickyAvx512(u_int64_t *planes, const u_int64_t *shift, u_int64_t *sticky,
+                                              u_int size, std::size_t stride, std::size_t count);
+
+    static std::size_t shiftLeftAvx512(u_int64_t *planes, const u_int64_t *shift, u_int size, std::size_t stride,
+                                       std::size_t count);
+};
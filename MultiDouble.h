@@ -0,0 +1,569 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "LimbArray.h"
+#include "NativeArithmetic.h"
+
+//Routing of VariableFloat arithmetic through double-double and quad-double numbers is opt-in (correct rounding of
+//results is not guaranteed).
+#ifndef OIAKFP_MULTIDOUBLE
+#define OIAKFP_MULTIDOUBLE 0
+#endif
+
+template<int fraction, int exponent>
+class VariableFloat;
+
+template<int terms>
+/// Floating point number represented by an unevaluated sum of 'terms' hardware doubles (double-double for 2 terms,
+/// quad-double for 4 terms). Components are ordered by decreasing magnitude and do not overlap, so a number carries
+/// about 53 * 'terms' significant bits within the exponent range of double. Arithmetic is built from error-free
+/// transformations (TwoSum, and TwoProd with fma) followed by renormalization.
+///
+/// Accuracy: operations are not correctly rounded. Their relative error stays below about 2^(4 - 53 * terms)
+/// (2^-102 for double-double, 2^-208 for quad-double) as long as no component leaves the normal range of double,
+/// i.e. lower components of numbers close to 2^-1022 lose precision and sums or products above about 2^1023
+/// overflow. Conversions from VariableFloat with up to 53 * 'terms' - 1 fraction bits are exact, conversions
+/// to VariableFloat round the exact value of the sum to nearest even.
+/// \tparam terms - component count.
+class MultiDouble
+{
+public:
+    static_assert(terms >= 2, "MultiDouble needs at least two components.");
+
+    /// Creates a number equal to zero.
+    MultiDouble() = default;
+
+    /// Creates a number equal to a double.
+    /// \param number - value.
+    explicit MultiDouble(double number) { components[0] = number; }
+
+    /// Converts a VariableFloat number multiplied by 2^scale (values outside of the range of double overflow
+    /// or underflow).
+    /// \param number - number to be converted.
+    /// \param scale - power of two applied to the number.
+    template<int fraction, int exponent>
+    explicit MultiDouble(const VariableFloat<fraction, exponent> &number, long long scale = 0);
+
+    /// Multiplies the number by 2^scale, rounds it to nearest even and stores it in a VariableFloat number.
+    /// \param number - destination.
+    /// \param scale - power of two applied to the number.
+    template<int fraction, int exponent>
+    void store(VariableFloat<fraction, exponent> &number, long long scale = 0) const;
+
+    /// Adds two numbers and stores the sum in 'result' (which may be the same object as any operand).
+    /// \param result - sum destination.
+    /// \param n1 - first addition operand.
+    /// \param n2 - second addition operand.
+    static void add(MultiDouble<terms> &result, const MultiDouble<terms> &n1, const MultiDouble<terms> &n2);
+
+    /// Subtracts two numbers and stores the difference in 'result' (which may be the same object as any operand).
+    /// \param result - difference destination.
+    /// \param n1 - first subtraction operand.
+    /// \param n2 - second subtraction operand.
+    static void subtract(MultiDouble<terms> &result, const MultiDouble<terms> &n1, const MultiDouble<terms> &n2);
+
+    /// Multiplies two numbers and stores the product in 'result' (which may be the same object as any operand).
+    /// \param result - product destination.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    static void multiply(MultiDouble<terms> &result, const MultiDouble<terms> &n1, const MultiDouble<terms> &n2);
+
+    /// Multiplies a number by a double and stores the product in 'result'.
+    /// \param result - product destination.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    static void multiply(MultiDouble<terms> &result, const MultiDouble<terms> &n1, double n2);
+
+    /// Divides two numbers and stores the quotient in 'result' (which may be the same object as any operand).
+    /// \param result - quotient destination.
+    /// \param n1 - dividend.
+    /// \param n2 - divisor.
+    static void divide(MultiDouble<terms> &result, const MultiDouble<terms> &n1, const MultiDouble<terms> &n2);
+
+    /// Computes a square root of a number and stores it in 'result' (which may be the same object as 'number').
+    /// \param result - square root destination.
+    /// \param number - number to find the square root of.
+    static void sqrt(MultiDouble<terms> &result, const MultiDouble<terms> &number);
+
+    /// Computes a square root of a number with twice as many components as the operand, so that the root rounded
+    /// to a format with up to about 53 * 'terms' fraction bits is almost always correct.
+    /// \param result - square root destination.
+    /// \param number - number to find the square root of.
+    static void sqrt(MultiDouble<2 * terms> &result, const MultiDouble<terms> &number);
+
+    void operator+=(const MultiDouble<terms> &operand) { add(*this, *this, operand); }
+    void operator-=(const MultiDouble<terms> &operand) { subtract(*this, *this, operand); }
+    void operator*=(const MultiDouble<terms> &operand) { multiply(*this, *this, operand); }
+    void operator/=(const MultiDouble<terms> &operand) { divide(*this, *this, operand); }
+
+    /// Returns a component of the number.
+    /// \param index - component index (0 - the most significant one).
+    /// \return Component value.
+    double getComponent(int index) const { return components[index]; }
+
+private:
+    /// Numbers with more components compute residuals of lower precision operations.
+    template<int> friend class MultiDouble;
+
+    /// Components ordered by decreasing magnitude.
+    std::array<double, terms> components{};
+
+    /// Computes a + b and its rounding error exactly.
+    static double twoSum(double a, double b, double &error)
+    {
+        const double sum = a + b;
+        const double bVirtual = sum - a;
+        error = (a - (sum - bVirtual)) + (b - bVirtual);
+        return sum;
+    }
+
+    /// Computes a + b and its rounding error exactly, the exponent of 'a' must not be lower than the one of 'b'.
+    static double fastTwoSum(double a, double b, double &error)
+    {
+        const double sum = a + b;
+        error = b - (sum - a);
+        return sum;
+    }
+
+    /// Computes a * b and its rounding error exactly.
+    static double twoProduct(double a, double b, double &error)
+    {
+        const double product = a * b;
+        error = std::fma(a, b, -product);
+        return product;
+    }
+
+    /// Sums values (roughly ordered by decreasing magnitude) into 'terms' nonoverlapping components:
+    /// a TwoSum pass from the least significant value followed by extraction of nonzero errors.
+    /// \param values - values, overwritten.
+    /// \param count - value count.
+    /// \param result - destination components.
+    static void renormalize(double *values, int count, std::array<double, terms> &result);
+};
+
+typedef MultiDouble<2> DoubleDouble;
+typedef MultiDouble<4> QuadDouble;
+
+template<int terms>
+MultiDouble<terms> operator + (const MultiDouble<terms> &n1, const MultiDouble<terms> &n2)
+{
+    MultiDouble<terms> result;
+    MultiDouble<terms>::add(result, n1, n2);
+    return result;
+}
+
+template<int terms>
+MultiDouble<terms> operator - (const MultiDouble<terms> &n1, const MultiDouble<terms> &n2)
+{
+    MultiDouble<terms> result;
+    MultiDouble<terms>::subtract(result, n1, n2);
+    return result;
+}
+
+template<int terms>
+MultiDouble<terms> operator * (const MultiDouble<terms> &n1, const MultiDouble<terms> &n2)
+{
+    MultiDouble<terms> result;
+    MultiDouble<terms>::multiply(result, n1, n2);
+    return result;
+}
+
+template<int terms>
+MultiDouble<terms> operator / (const MultiDouble<terms> &n1, const MultiDouble<terms> &n2)
+{
+    MultiDouble<terms> result;
+    MultiDouble<terms>::divide(result, n1, n2);
+    return result;
+}
+
+template<int fraction, int exponent>
+/// Static class implementing VariableFloat arithmetic with double-double (fractions of up to 104 bits) or quad-double
+/// (up to 208 bits) numbers: operands are converted, the operation is done on hardware doubles and the result is
+/// rounded back to the format. Operands are scaled to exponents close to zero and the exponent of the result is
+/// applied on conversion back, so the range of double does not limit the format. VariableFloat uses it instead of
+/// limb arithmetic when OIAKFP_MULTIDOUBLE is 1, for formats with exponents of up to 62 bits and fractions of up to
+/// 208 bits that have no (correctly rounded) native arithmetic, i.e. fractions of 124 - 208 bits unless OIAKFP_NATIVE
+/// is 0.
+///
+/// Accuracy (measured against exact results): sums, products and quotients are computed with one more component
+/// (at least 53 guard bits) and square roots with twice as many components, the result is rounded once on conversion
+/// back. All of them were correctly rounded in 50000 measured cases per operation and format (fractions of 59 - 208
+/// bits, test/AccuracyCheck.cpp), but this is not guaranteed. Operands must not be zero, infinity or NaN.
+/// \tparam fraction - fraction bit count.
+/// \tparam exponent - exponent bit count.
+class MultiDoubleArithmetic
+{
+public:
+    typedef VariableFloat<fraction, exponent> Float;
+
+    /// Component count of the numbers used for the format.
+    static constexpr int TERMS = fraction <= 104 ? 2 : 4;
+
+    typedef MultiDouble<TERMS> Number;
+
+    /// Numbers with one more component, used for sums, products and quotients, so that their last place is
+    /// rounded only once.
+    typedef MultiDouble<TERMS + 1> Wide;
+
+    /// Format is routed through multi-double arithmetic (only if it has no native arithmetic).
+    static constexpr bool ENABLED = OIAKFP_MULTIDOUBLE && !NativeArithmetic<fraction, exponent>::ENABLED &&
+                                    exponent <= 62 && fraction <= 208;
+
+    static void add(Float &result, const Float &n1, const Float &n2)
+    {
+        //Scaling the lower operand below the range of double only loses bits below half ulp of the higher one.
+        const long long scale = std::max(loadExponent(n1), loadExponent(n2));
+        Wide sum;
+        Wide::add(sum, Wide(n1, -scale), Wide(n2, -scale));
+        sum.store(result, scale);
+    }
+
+    static void multiply(Float &result, const Float &n1, const Float &n2)
+    {
+        const long long first = loadExponent(n1), second = loadExponent(n2);
+        Wide product;
+        Wide::multiply(product, Wide(n1, -first), Wide(n2, -second));
+        product.store(result, first + second);
+    }
+
+    static void divide(Float &result, const Float &n1, const Float &n2)
+    {
+        const long long first = loadExponent(n1), second = loadExponent(n2);
+        Wide quotient;
+        Wide::divide(quotient, Wide(n1, -first), Wide(n2, -second));
+        quotient.store(result, first - second);
+    }
+
+    static void sqrt(Float &result, const Float &number)
+    {
+        //Even scale keeps the root exact: the operand is in [1, 4). Root with twice as many components is rounded
+        //directly, so that its last place is not rounded twice.
+        const long long half = loadExponent(number) >> 1;
+        MultiDouble<2 * TERMS> root;
+        Number::sqrt(root, Number(number, -2 * half));
+        root.store(result, half);
+    }
+
+private:
+    /// Returns the unbiased exponent of a number.
+    static long long loadExponent(const Float &number)
+    {
+        return (long long) number.getExponentContainer()[0] - ((1LL << (exponent - 1)) - 1);
+    }
+};
+
+template<int fraction, int exponent>
+constexpr int MultiDoubleArithmetic<fraction, exponent>::TERMS;
+
+template<int fraction, int exponent>
+constexpr bool MultiDoubleArithmetic<fraction, exponent>::ENABLED;
+
+template<int terms>
+void MultiDouble<terms>::renormalize(double *values, int count, std::array<double, terms> &result)
+{
+    for (int i = count - 1; i > 0; --i) values[i - 1] = twoSum(values[i - 1], values[i], values[i]);
+
+    //Every nonzero error starts a new component, values left after the last one are added to it.
+    result.fill(0);
+    int index = 0;
+    double current = values[0];
+    for (int i = 1; i < count; ++i)
+    {
+        if (index == terms - 1)
+        {
+            current += values[i];
+            continue;
+        }
+        double error;
+        const double sum = fastTwoSum(current, values[i], error);
+        if (error != 0)
+        {
+            result[index++] = sum;
+            current = error;
+        }
+        else current = sum;
+    }
+    result[index] = current;
+}
+
+template<int terms>
+void MultiDouble<terms>::add(MultiDouble<terms> &result, const MultiDouble<terms> &n1, const MultiDouble<terms> &n2)
+{
+    //Overflow is not carried into the lower components (it would make them NaN).
+    const double estimate = n1.components[0] + n2.components[0];
+    if (!std::isfinite(estimate))
+    {
+        result = MultiDouble<terms>(estimate);
+        return;
+    }
+
+    //Merge components of both operands by decreasing magnitude.
+    std::array<double, 2 * terms> merged;
+    int first = 0, second = 0;
+    for (int i = 0; i < 2 * terms; ++i)
+    {
+        if (second == terms || (first < terms && std::fabs(n1.components[first]) >= std::fabs(n2.components[second])))
+            merged[i] = n1.components[first++];
+        else merged[i] = n2.components[second++];
+    }
+    renormalize(merged.data(), 2 * terms, result.components);
+}
+
+template<int terms>
+void MultiDouble<terms>::subtract(MultiDouble<terms> &result, const MultiDouble<terms> &n1,
+                                  const MultiDouble<terms> &n2)
+{
+    MultiDouble<terms> negated;
+    for (int i = 0; i < terms; ++i) negated.components[i] = -n2.components[i];
+    add(result, n1, negated);
+}
+
+template<int terms>
+void MultiDouble<terms>::multiply(MultiDouble<terms> &result, const MultiDouble<terms> &n1,
+                                  const MultiDouble<terms> &n2)
+{
+    const double estimate = n1.components[0] * n2.components[0];
+    if (!std::isfinite(estimate) || estimate == 0)
+    {
+        result = MultiDouble<terms>(estimate);
+        return;
+    }
+
+    //Partial products are summed by order (i + j) with TwoSum, errors of every order are carried to the next one.
+    //Products of order 'terms' are added without error terms, higher orders are dropped.
+    std::array<double, terms + 1> orders;
+    std::array<double, terms * terms> carried;
+    int carriedCount = 0;
+    for (int order = 0; order < terms; ++order)
+    {
+        std::array<double, terms * terms> errors;
+        int errorCount = 0;
+        double sum = twoProduct(n1.components[0], n2.components[order], errors[errorCount++]);
+        for (int i = 1; i <= order; ++i)
+        {
+            double productError;
+            const double product = twoProduct(n1.components[i], n2.components[order - i], productError);
+            errors[errorCount++] = productError;
+            sum = twoSum(sum, product, errors[errorCount++]);
+        }
+        for (int i = 0; i < carriedCount; ++i) sum = twoSum(sum, carried[i], errors[errorCount++]);
+        orders[order] = sum;
+        carried = errors;
+        carriedCount = errorCount;
+    }
+
+    double tail = 0;
+    for (int i = 1; i < terms; ++i) tail += n1.components[i] * n2.components[terms - i];
+    for (int i = 0; i < carriedCount; ++i) tail += carried[i];
+    orders[terms] = tail;
+    renormalize(orders.data(), terms + 1, result.components);
+}
+
+template<int terms>
+void MultiDouble<terms>::multiply(MultiDouble<terms> &result, const MultiDouble<terms> &n1, double n2)
+{
+    const double estimate = n1.components[0] * n2;
+    if (!std::isfinite(estimate) || estimate == 0)
+    {
+        result = MultiDouble<terms>(estimate);
+        return;
+    }
+
+    std::array<double, 2 * terms> products;
+    for (int i = 0; i < terms; ++i) products[2 * i] = twoProduct(n1.components[i], n2, products[2 * i + 1]);
+    renormalize(products.data(), 2 * terms, result.components);
+}
+
+template<int terms>
+void MultiDouble<terms>::divide(MultiDouble<terms> &result, const MultiDouble<terms> &n1,
+                                const MultiDouble<terms> &n2)
+{
+    const double estimate = n1.components[0] / n2.components[0];
+    if (!std::isfinite(estimate) || estimate == 0)
+    {
+        result = MultiDouble<terms>(estimate);
+        return;
+    }
+
+    //Long division: every quotient digit is the leading component of the remainder over the leading component
+    //of the divisor.
+    std::array<double, terms + 1> digits;
+    MultiDouble<terms> remainder = n1, product;
+    for (int i = 0; i <= terms; ++i)
+    {
+        digits[i] = remainder.components[0] / n2.components[0];
+        if (i == terms) break;
+        multiply(product, n2, digits[i]);
+        subtract(remainder, remainder, product);
+    }
+    renormalize(digits.data(), terms + 1, result.components);
+}
+
+template<int terms>
+void MultiDouble<terms>::sqrt(MultiDouble<terms> &result, const MultiDouble<terms> &number)
+{
+    //Components of the wider root are ordered and do not overlap, the lower half is dropped.
+    MultiDouble<2 * terms> root;
+    sqrt(root, number);
+    std::copy(root.components.begin(), root.components.begin() + terms, result.components.begin());
+}
+
+template<int terms>
+void MultiDouble<terms>::sqrt(MultiDouble<2 * terms> &result, const MultiDouble<terms> &number)
+{
+    const double leading = number.components[0];
+    if (!(leading > 0) || std::isinf(leading))
+    {
+        result = MultiDouble<2 * terms>(leading == 0 || std::isinf(leading) ? leading :
+                                        std::numeric_limits<double>::quiet_NaN());
+        return;
+    }
+
+    //Newton iteration for 1 / sqrt(number), x += x * (1/2 - number / 2 * x^2), doubles the correct bits.
+    MultiDouble<terms> inverse(1 / std::sqrt(leading)), half, step;
+    multiply(half, number, 0.5);
+    for (int bits = 53; 2 * bits < 53 * terms + 8; bits *= 2)
+    {
+        multiply(step, inverse, inverse);
+        multiply(step, step, half);
+        subtract(step, MultiDouble<terms>(0.5), step);
+        multiply(step, step, inverse);
+        add(inverse, inverse, step);
+    }
+
+    //Final step on the root itself: r = number * x, r += x * (number - r^2) / 2. The residual cancels the leading
+    //half of the bits of r^2 and the corrected root carries more bits than 'terms' components, so both are computed
+    //with twice as many components.
+    MultiDouble<terms> root;
+    multiply(root, number, inverse);
+    MultiDouble<2 * terms> wideRoot, square, residual;
+    std::copy(root.components.begin(), root.components.end(), wideRoot.components.begin());
+    std::copy(number.components.begin(), number.components.end(), residual.components.begin());
+    MultiDouble<2 * terms>::multiply(square, wideRoot, wideRoot);
+    MultiDouble<2 * terms>::subtract(residual, residual, square);
+    std::copy(residual.components.begin(), residual.components.begin() + terms, step.components.begin());
+    multiply(step, step, inverse);
+    multiply(step, step, 0.5);
+    std::copy(step.components.begin(), step.components.end(), residual.components.begin());
+    std::fill(residual.components.begin() + terms, residual.components.end(), 0);
+    MultiDouble<2 * terms>::add(result, wideRoot, residual);
+}
+
+template<int terms>
+template<int fraction, int exponent>
+MultiDouble<terms>::MultiDouble(const VariableFloat<fraction, exponent> &number, long long scale)
+{
+    static_assert(exponent <= 62, "Conversion needs an exponent stored in a single limb.");
+    typedef VariableFloat<fraction, exponent> Float;
+    const double sign = number.getSign() ? -1 : 1;
+    if (number.isZero())
+    {
+        components[0] = sign * 0.0;
+        return;
+    }
+    else if (number.isNan())
+    {
+        components[0] = std::numeric_limits<double>::quiet_NaN();
+        return;
+    }
+    else if (number.isInfinity())
+    {
+        components[0] = sign * std::numeric_limits<double>::infinity();
+        return;
+    }
+
+    //Split the significand into 53-bit chunks from its highest order bit.
+    const long long unbiased = (long long) number.getExponentContainer()[0] - ((1LL << (exponent - 1)) - 1) + scale;
+    const auto &limbs = number.getFractionContainer();
+    std::array<double, terms> chunks;
+    for (int i = 0; i < terms; ++i)
+    {
+        const int offset = 53 * i;
+        const int limb = (int) Float::fractionLimbs - 1 - offset / 64;
+        u_int64_t chunk = 0;
+        if (limb >= 0)
+        {
+            const u_int128_t window = ((u_int128_t) limbs[limb] << 64) | (limb > 0 ? limbs[limb - 1] : 0);
+            chunk = (u_int64_t) ((window << (offset % 64)) >> (128 - 53));
+        }
+        chunks[i] = sign * std::ldexp((double) chunk, (int) std::max<long long>(std::min<long long>(
+                unbiased - 52 - offset, 1 << 20), -(1 << 20)));
+    }
+    renormalize(chunks.data(), terms, components);
+}
+
+template<int terms>
+template<int fraction, int exponent>
+void MultiDouble<terms>::store(VariableFloat<fraction, exponent> &number, long long scale) const
+{
+    typedef VariableFloat<fraction, exponent> Float;
+    const double leading = components[0];
+    if (std::isnan(leading))
+    {
+        number.setNan();
+        return;
+    }
+    else if (std::isinf(leading))
+    {
+        number.setInfinity(leading < 0);
+        return;
+    }
+    else if (leading == 0)
+    {
+        number.setZero(std::signbit(leading));
+        return;
+    }
+
+    //Components are added exactly into a two's complement register whose lowest order bit has a weight of
+    //2^(lowest - 1). Components below 2^(lowest - 1) (and all following ones) are not added, their sum is smaller
+    //than 2^lowest and has the sign of the first of them, so it only decides the lowest order (sticky) bit.
+    int leadingExponent;
+    std::frexp(leading, &leadingExponent);
+    long long lowest = leadingExponent - (fraction + 1) - 3;
+    std::array<u_int64_t, terms> mantissas;
+    std::array<long long, terms> weights;
+    int added = 0;
+    for (; added < terms && components[added] != 0; ++added)
+    {
+        int componentExponent;
+        const double mantissa = std::frexp(std::fabs(components[added]), &componentExponent);
+        if (componentExponent < lowest) break;
+        mantissas[added] = (u_int64_t) std::ldexp(mantissa, 53);
+        weights[added] = componentExponent - 53;
+        const int zeros = __builtin_ctzll(mantissas[added]);
+        mantissas[added] >>= zeros;
+        weights[added] += zeros;
+        lowest = std::min(lowest, weights[added]);
+    }
+    const double rest = added < terms ? components[added] : 0;
+
+    //Register spans the significand, guard bits, bits added by lower components and a sign limb.
+    const u_int size = (fraction + 6 + 53 * terms) / 64 + 2;
+    std::array<u_int64_t, size> significand{};
+    for (int i = 0; i < added; ++i)
+    {
+        std::array<u_int64_t, size> aligned{};
+        const auto shift = (u_int) (weights[i] - (lowest - 1));
+        aligned[shift / 64] = mantissas[i] << (shift % 64);
+        if (shift % 64 != 0 && shift / 64 + 1 < size) aligned[shift / 64 + 1] = mantissas[i] >> (64 - shift % 64);
+        if (components[i] < 0) LimbArray::subtractLimbs(significand.data(), aligned.data(), size);
+        else LimbArray::addLimbs(significand.data(), aligned.data(), size);
+    }
+    if (rest > 0) LimbArray::addLimb(significand.data(), size, 1);
+    else if (rest < 0) LimbArray::subtractLimb(significand.data(), size, 1);
+
+    const bool negative = significand[size - 1] >> 63;
+    if (negative) LimbArray::negateLimbs(significand.data(), size);
+    if (LimbArray::checkIfZero(significand.data(), size))
+    {
+        number.setZero(false);
+        return;
+    }
+    typename Float::ExponentWork resultExponent = Float::loadExponent(Float::getBias());
+    Float::adjustExponent(resultExponent, lowest - 1 + 64 * (long long) size - 1 + scale);
+    number.setResult(negative, resultExponent, significand.data(), size);
+}
@@ -0,0 +1,393 @@
+#pragma once
+
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include "LimbArray.h"
+
+//Native arithmetic can be turned off at build time (e.g. to compare it with limb arithmetic).
+#ifndef OIAKFP_NATIVE
+#define OIAKFP_NATIVE 1
+#endif
+
+template<int fraction, int exponent>
+class VariableFloat;
+
+/// Native unsigned integer holding a significand of a given format with a carry bit and at least three guard bits.
+/// \tparam fraction - fraction bit count.
+/// \tparam exponent - exponent bit count.
+template<int fraction, int exponent>
+struct NativeWord
+{
+    /// u_int64_t or u_int128_t, void if the format needs limb arithmetic (wider fraction or exponent over 62 bits)
+    /// or OIAKFP_NATIVE is 0.
+    typedef typename std::conditional<(!OIAKFP_NATIVE || exponent > 62 || fraction > 123), void,
+            typename std::conditional<(fraction <= 59), u_int64_t, u_int128_t>::type>::type Type;
+};
+
+template<int fraction, int exponent, typename Word = typename NativeWord<fraction, exponent>::Type>
+/// Static class implementing VariableFloat arithmetic of narrow formats with native integers.
+/// The significand is held in a single u_int64_t or u_int128_t and the biased exponent in a long long, leading zeros
+/// are counted with __builtin_clzll. Results are rounded to nearest even and overflow or underflow like setResult
+/// does, so they are identical to the ones of limb arithmetic. Operands must not be zero, infinity or NaN.
+/// \tparam fraction - fraction bit count.
+/// \tparam exponent - exponent bit count.
+/// \tparam Word - native significand type.
+class NativeArithmetic
+{
+public:
+    typedef VariableFloat<fraction, exponent> Float;
+
+    /// Format has native arithmetic.
+    static constexpr bool ENABLED = true;
+
+    /// NativeArithmetic static class default constructor.
+    NativeArithmetic() = default;
+
+    /// Adds two finite, nonzero numbers and stores the sum in 'result'.
+    /// \param result - sum destination.
+    /// \param n1 - first addition operand.
+    /// \param n2 - second addition operand.
+    static void add(Float &result, const Float &n1, const Float &n2);
+
+    /// Multiplies two finite, nonzero numbers and stores the product in 'result'.
+    /// \param result - product destination.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    static void multiply(Float &result, const Float &n1, const Float &n2);
+
+    /// Divides two finite, nonzero numbers and stores the quotient in 'result'.
+    /// \param result - quotient destination.
+    /// \param n1 - dividend.
+    /// \param n2 - divisor.
+    static void divide(Float &result, const Float &n1, const Float &n2);
+
+    /// Computes a square root of a finite, positive number and stores it in 'result'.
+    /// \param result - square root destination.
+    /// \param number - number to find the square root of.
+    static void sqrt(Float &result, const Float &number);
+
+    /// Normalizes, rounds and stores a result.
+    /// \param result - destination.
+    /// \param resultSign - sign of the result.
+    /// \param resultExponent - biased exponent of bit 'fraction' of 'significand'.
+    /// \param significand - nonzero significand, lowest order bit must include the sticky bit
+    /// (and lie at least two bits below the rounding position if it is set).
+    static void round(Float &result, bool resultSign, long long resultExponent, Word significand);
+
+private:
+    /// Bit count of the significand word.
+    static constexpr int WORD_BITS = 8 * sizeof(Word);
+
+    /// Guard bits below the significand of an addition operand (the highest order bit is left for the carry).
+    static constexpr int GUARD_BITS = WORD_BITS - 2 - fraction;
+
+    /// Right shift of a product of significands, so that it fits in a word with the highest order bit free.
+    static constexpr int PRODUCT_SHIFT = 2 * fraction + 3 > WORD_BITS ? 2 * fraction + 3 - WORD_BITS : 0;
+
+    /// Shift aligning the significand ('fraction' + 1 bits) with the top of the fraction container.
+    static constexpr int CONTAINER_SHIFT = 64 * (fraction / 64 + 1) - 1 - fraction;
+
+    /// Bias and the highest biased exponent of a finite number.
+    static constexpr long long BIAS = (1LL << (exponent - 1)) - 1;
+    static constexpr long long MAX_EXPONENT = (1LL << exponent) - 2;
+
+    /// Counts leading zeros of a nonzero word.
+    static int countLeadingZeros(u_int64_t value) { return __builtin_clzll(value); }
+    static int countLeadingZeros(u_int128_t value)
+    {
+        const auto high = (u_int64_t) (value >> 64);
+        return high != 0 ? __builtin_clzll(high) : 64 + __builtin_clzll((u_int64_t) value);
+    }
+
+    /// Computes a double width product of two words.
+    static void multiplyWide(u_int64_t n1, u_int64_t n2, u_int64_t &high, u_int64_t &low)
+    {
+        const u_int128_t product = (u_int128_t) n1 * n2;
+        high = (u_int64_t) (product >> 64);
+        low = (u_int64_t) product;
+    }
+    static void multiplyWide(u_int128_t n1, u_int128_t n2, u_int128_t &high, u_int128_t &low);
+
+    /// Divides a double width dividend by a word, the quotient has to fit in a word.
+    /// \param high - dividend higher order word (less than 'divisor' once both are normalized).
+    /// \param low - dividend lower order word.
+    /// \param divisor - nonzero divisor.
+    /// \param quotient - quotient destination.
+    /// \return true if the remainder is not zero.
+    static bool divideWide(u_int64_t high, u_int64_t low, u_int64_t divisor, u_int64_t &quotient)
+    {
+        const u_int128_t dividend = ((u_int128_t) high << 64) | low;
+        quotient = (u_int64_t) (dividend / divisor);
+        return dividend != (u_int128_t) quotient * divisor;
+    }
+    static bool divideWide(u_int128_t high, u_int128_t low, u_int128_t divisor, u_int128_t &quotient);
+
+    /// Computes the integer square root of a double width radicand.
+    /// \param high - radicand higher order word.
+    /// \param low - radicand lower order word.
+    /// \param root - root destination.
+    /// \return true if the root is inexact.
+    static bool squareRootWide(Word high, Word low, Word &root);
+
+    /// Shifts a word left into a double width value.
+    /// \param value - word to shift.
+    /// \param shift - shift (1 to 'WORD_BITS').
+    /// \param high - higher order word destination.
+    /// \param low - lower order word destination.
+    static void shiftLeftWide(Word value, int shift, Word &high, Word &low)
+    {
+        high = value >> (WORD_BITS - shift);
+        low = value << (shift - 1) << 1;
+    }
+
+    /// Loads the significand of a number ('fraction' + 1 bits, the hidden '1' included).
+    static Word loadSignificand(const Float &number);
+
+    /// Loads the biased exponent of a number.
+    static long long loadExponent(const Float &number) { return (long long) number.getExponentContainer()[0]; }
+};
+
+/// Formats wider than a native significand word.
+template<int fraction, int exponent>
+class NativeArithmetic<fraction, exponent, void>
+{
+public:
+    static constexpr bool ENABLED = false;
+};
+
+template<int fraction, int exponent, typename Word>
+constexpr bool NativeArithmetic<fraction, exponent, Word>::ENABLED;
+
+template<int fraction, int exponent>
+constexpr bool NativeArithmetic<fraction, exponent, void>::ENABLED;
+
+template<int fraction, int exponent, typename Word>
+void NativeArithmetic<fraction, exponent, Word>::multiplyWide(u_int128_t n1, u_int128_t n2,
+                                                              u_int128_t &high, u_int128_t &low)
+{
+    //Four 64 x 64 bit partial products.
+    const u_int128_t mask = ~(u_int64_t) 0;
+    const u_int128_t lowLow = (n1 & mask) * (n2 & mask);
+    const u_int128_t lowHigh = (n1 & mask) * (n2 >> 64);
+    const u_int128_t highLow = (n1 >> 64) * (n2 & mask);
+    const u_int128_t highHigh = (n1 >> 64) * (n2 >> 64);
+
+    const u_int128_t middle = (lowLow >> 64) + (lowHigh & mask) + (highLow & mask);
+    low = (middle << 64) | (lowLow & mask);
+    high = highHigh + (lowHigh >> 64) + (highLow >> 64) + (middle >> 64);
+}
+
+template<int fraction, int exponent, typename Word>
+Word NativeArithmetic<fraction, exponent, Word>::loadSignificand(const Float &number)
+{
+    Word container = 0;
+    for (u_int i = 0; i < Float::fractionLimbs; ++i)
+        container |= (Word) number.getFractionContainer()[i] << (64 * i);
+    return container >> CONTAINER_SHIFT;
+}
+
+template<int fraction, int exponent, typename Word>
+void NativeArithmetic<fraction, exponent, Word>::add(Float &result, const Float &n1, const Float &n2)
+{
+    long long higherExponent = loadExponent(n1);
+    long long lowerExponent = loadExponent(n2);
+    Word higher = loadSignificand(n1);
+    Word lower = loadSignificand(n2);
+    bool resultSign = n1.getSign();
+
+    //|n2| > |n1|
+    if (lowerExponent > higherExponent || (lowerExponent == higherExponent && lower > higher))
+    {
+        std::swap(higherExponent, lowerExponent);
+        std::swap(higher, lower);
+        resultSign = n2.getSign();
+    }
+
+    //Align the lower significand, bits shifted out are kept as a sticky bit.
+    const long long difference = higherExponent - lowerExponent;
+    higher <<= GUARD_BITS;
+    lower <<= GUARD_BITS;
+    if (difference >= WORD_BITS) lower = 1;
+    else
+    {
+        const bool sticky = (lower & (((Word) 1 << difference) - 1)) != 0;
+        lower = (lower >> difference) | sticky;
+    }
+
+    if (n1.getSign() == n2.getSign()) higher += lower;
+    else
+    {
+        higher -= lower;
+        if (higher == 0)
+        {
+            result.setZero(false);
+            return;
+        }
+    }
+    round(result, resultSign, higherExponent - GUARD_BITS, higher);
+}
+
+template<int fraction, int exponent, typename Word>
+void NativeArithmetic<fraction, exponent, Word>::multiply(Float &result, const Float &n1, const Float &n2)
+{
+    Word high, low;
+    multiplyWide(loadSignificand(n1), loadSignificand(n2), high, low);
+
+    //Product has at most 2 * 'fraction' + 2 bits, it is shifted right with the bits shifted out kept as a sticky bit.
+    const bool sticky = (low & (((Word) 1 << PRODUCT_SHIFT) - 1)) != 0;
+    const Word product = (high << (WORD_BITS - 1 - PRODUCT_SHIFT) << 1) | (low >> PRODUCT_SHIFT) | sticky;
+    round(result, n1.getSign() != n2.getSign(),
+          loadExponent(n1) + loadExponent(n2) - BIAS - fraction + PRODUCT_SHIFT, product);
+}
+
+template<int fraction, int exponent, typename Word>
+void NativeArithmetic<fraction, exponent, Word>::divide(Float &result, const Float &n1, const Float &n2)
+{
+    //Quotient of significands shifted by 'fraction' + 3 bits has at least 'fraction' + 3 bits.
+    Word high, low, quotient;
+    shiftLeftWide(loadSignificand(n1), fraction + 3, high, low);
+    const bool inexact = divideWide(high, low, loadSignificand(n2), quotient);
+    round(result, n1.getSign() != n2.getSign(), loadExponent(n1) - loadExponent(n2) + BIAS - 3, quotient | inexact);
+}
+
+template<int fraction, int exponent, typename Word>
+void NativeArithmetic<fraction, exponent, Word>::sqrt(Float &result, const Float &number)
+{
+    //Radicand is the significand shifted by 'fraction' + 4 or 'fraction' + 5 bits, so that the exponent is even
+    //and the root has at least 'fraction' + 3 bits.
+    const long long unbiased = loadExponent(number) - BIAS;
+    const int shift = fraction + 4 + (int) (unbiased & 1);
+    Word high, low, root;
+    shiftLeftWide(loadSignificand(number), shift, high, low);
+    const bool inexact = squareRootWide(high, low, root);
+    round(result, false, (unbiased - fraction - shift) / 2 + fraction + BIAS, root | inexact);
+}
+
+template<int fraction, int exponent, typename Word>
+bool NativeArithmetic<fraction, exponent, Word>::divideWide(u_int128_t high, u_int128_t low, u_int128_t divisor,
+                                                            u_int128_t &quotient)
+{
+    //Normalize, so that the highest order bit of the divisor is set.
+    const int normalization = countLeadingZeros(divisor);
+    divisor <<= normalization;
+    if (normalization != 0) high = (high << normalization) | (low >> (128 - normalization));
+    low <<= normalization;
+
+    //Long division with 64-bit digits, each quotient digit is estimated from the highest order divisor digit
+    //and corrected (Knuth's algorithm D).
+    const u_int128_t mask = ~(u_int64_t) 0;
+    const auto divisorHigh = (u_int64_t) (divisor >> 64);
+    const auto divisorLow = (u_int64_t) divisor;
+    u_int128_t remainder = high;
+    quotient = 0;
+    for (int digit = 1; digit >= 0; --digit)
+    {
+        const auto next = (u_int64_t) (low >> (64 * digit));
+        u_int128_t estimate = (remainder >> 64) >= divisorHigh ? mask : remainder / divisorHigh;
+        u_int128_t estimateRemainder = remainder - estimate * divisorHigh;
+        while (estimateRemainder <= mask && estimate * divisorLow > ((estimateRemainder << 64) | next))
+        {
+            estimate--;
+            estimateRemainder += divisorHigh;
+        }
+
+        //Subtract estimate * divisor from the 192-bit partial remainder, add the divisor back if it was too large.
+        const u_int128_t productLow = estimate * divisorLow;
+        const u_int128_t productHigh = estimate * divisorHigh + (productLow >> 64);
+        const u_int128_t partial = (remainder << 64) | next;
+        const u_int128_t product = (productHigh << 64) | (productLow & mask);
+        const auto partialTop = (u_int64_t) (remainder >> 64);
+        const auto productTop = (u_int64_t) (productHigh >> 64);
+        remainder = partial - product;
+        if (partialTop < productTop || (partialTop == productTop && partial < product))
+        {
+            estimate--;
+            remainder += divisor;
+        }
+        quotient = (quotient << 64) | estimate;
+    }
+    return remainder != 0;
+}
+
+template<int fraction, int exponent, typename Word>
+bool NativeArithmetic<fraction, exponent, Word>::squareRootWide(Word high, Word low, Word &root)
+{
+    //Floating point estimate from the highest order bits (an even shift keeps the root exact).
+    const int bits = high != 0 ? 2 * WORD_BITS - countLeadingZeros(high) : WORD_BITS - countLeadingZeros(low);
+    int shift = bits > 64 ? bits - 64 : 0;
+    shift += shift & 1;
+    Word top = shift >= WORD_BITS ? high >> (shift - WORD_BITS) :
+               shift == 0 ? low : (high << (WORD_BITS - shift)) | (low >> shift);
+    root = (Word) std::ldexp(std::sqrt((double) top), shift / 2);
+
+    //Newton steps double the number of correct bits of the estimate (53 bits initially).
+    for (int correctBits = 53; correctBits < WORD_BITS; correctBits *= 2)
+    {
+        Word quotient;
+        divideWide(high, low, root, quotient);
+        root = (Word) ((root >> 1) + (quotient >> 1) + (root & quotient & 1));
+    }
+
+    //Correct the root to the integer square root.
+    Word squareHigh, squareLow;
+    multiplyWide(root, root, squareHigh, squareLow);
+    while (squareHigh > high || (squareHigh == high && squareLow > low))
+    {
+        root--;
+        multiplyWide(root, root, squareHigh, squareLow);
+    }
+    while (true)
+    {
+        Word nextHigh, nextLow;
+        multiplyWide(root + 1, root + 1, nextHigh, nextLow);
+        if (nextHigh > high || (nextHigh == high && nextLow > low)) break;
+        root++;
+        squareHigh = nextHigh;
+        squareLow = nextLow;
+    }
+    return squareHigh != high || squareLow != low;
+}
+
+template<int fraction, int exponent, typename Word>
+void NativeArithmetic<fraction, exponent, Word>::round(Float &result, bool resultSign, long long resultExponent,
+                                                       Word significand)
+{
+    //Normalize, so that bit 'fraction' is the hidden '1', bits below it are rounded to nearest even.
+    const int top = WORD_BITS - 1 - countLeadingZeros(significand);
+    if (top < fraction)
+    {
+        significand <<= fraction - top;
+        resultExponent -= fraction - top;
+    }
+    else if (top > fraction)
+    {
+        const int excess = top - fraction;
+        const Word remainder = significand & (((Word) 1 << excess) - 1);
+        const Word half = (Word) 1 << (excess - 1);
+        significand >>= excess;
+        resultExponent += excess;
+        if (remainder > half || (remainder == half && (significand & 1)))
+        {
+            //Carry out of the significand means it became 1.0 * 2.
+            if (++significand >> (fraction + 1))
+            {
+                significand >>= 1;
+                resultExponent++;
+            }
+        }
+    }
+
+    if (resultExponent > MAX_EXPONENT) result.setInfinity(resultSign);
+    else if (resultExponent < 1) result.setZero(resultSign);
+    else
+    {
+        typename Float::ExponentLimbs resultExponentLimbs{};
+        typename Float::FractionLimbs resultFraction;
+        resultExponentLimbs[0] = (u_int64_t) resultExponent;
+        const Word container = significand << CONTAINER_SHIFT;
+        for (u_int i = 0; i < Float::fractionLimbs; ++i) resultFraction[i] = (u_int64_t) (container >> (64 * i));
+        result.setContainers(resultSign, resultExponentLimbs, resultFraction);
+    }
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <mutex>
+
+#include "KulischAccumulator.h"
+#include "ThreadPool.h"
+#include "VariableFloat.h"
+
+/// Cost classes of scalar operations, used to choose chunk lengths of parallel batches.
+enum class BatchCost
+{
+    Add,
+    Multiply,
+    Divide,
+    SquareRoot,
+    Fma
+};
+
+/// Parallel batch API. Operations are applied to every element of operand spans (pointer and element count)
+/// on a work stealing ThreadPool, with results equal to the scalar vf API applied element by element.
+/// Destination may be the same span as any operand.
+namespace vf
+{
+    namespace parallel
+    {
+        /// Returns chunk length (elements that are not split between threads) for operations of given cost,
+        /// so that a chunk takes tens of microseconds: long enough to hide scheduling, short enough to balance.
+        /// \param cost - cost class of the operation.
+        /// \return Chunk length in elements.
+        template<int fraction>
+        std::size_t chunkLength(BatchCost cost)
+        {
+            //Cost estimated in limb operations, division and square root take a few Newton steps.
+            const std::size_t TARGET = 1 << 14;
+            const std::size_t limbs = fraction / 64 + 1;
+            const std::size_t product = 8 + limbs * limbs;
+            std::size_t estimate;
+            switch (cost)
+            {
+                case BatchCost::Add:
+                    estimate = 8 + limbs;
+                    break;
+                case BatchCost::Divide:
+                    estimate = 4 * product;
+                    break;
+                case BatchCost::SquareRoot:
+                    estimate = 6 * product;
+                    break;
+                case BatchCost::Fma:
+                    estimate = product + limbs;
+                    break;
+                default:
+                    estimate = product;
+            }
+            return std::max<std::size_t>(TARGET / estimate, 1);
+        }
+
+        /// Calls 'operation(i)' for every index i in 0 .. 'count' - 1.
+        /// \param count - index count.
+        /// \param chunk - chunk length (see 'chunkLength').
+        /// \param operation - function called with an index, must be safe to call concurrently.
+        /// \param pool - pool to run on.
+        template<typename Operation>
+        void forEach(std::size_t count, std::size_t chunk, Operation operation,
+                     ThreadPool &pool = ThreadPool::global())
+        {
+            pool.run(count, chunk, [&operation](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i) operation(i);
+            });
+        }
+
+        /// Applies a unary kernel storing its result in the first argument: operation(out[i], a[i]).
+        /// \param out - destination span.
+        /// \param a - operand span.
+        /// \param count - element count.
+        /// \param operation - kernel, e.g. a lambda over VariableFloat.
+        /// \param cost - cost class of the kernel.
+        /// \param pool - pool to run on.
+        template<int fraction, int exponent, typename Operation>
+        void apply(VariableFloat<fraction, exponent> *out, const VariableFloat<fraction, exponent> *a,
+                   std::size_t count, Operation operation, BatchCost cost = BatchCost::Multiply,
+                   ThreadPool &pool = ThreadPool::global())
+        {
+            forEach(count, chunkLength<fraction>(cost), [&](std::size_t i) { operation(out[i], a[i]); }, pool);
+        }
+
+        /// Applies a binary kernel storing its result in the first argument: operation(out[i], a[i], b[i]).
+        /// \param out - destination span.
+        /// \param a - first operand span.
+        /// \param b - second operand span.
+        /// \param count - element count.
+        /// \param operation - kernel, e.g. VariableFloat::add or a lambda over VariableFloat.
+        /// \param cost - cost class of the kernel.
+        /// \param pool - pool to run on.
+        template<int fraction, int exponent, typename Operation>
+        void apply(VariableFloat<fraction, exponent> *out, const VariableFloat<fraction, exponent> *a,
+                   const VariableFloat<fraction, exponent> *b, std::size_t count, Operation operation,
+                   BatchCost cost = BatchCost::Multiply, ThreadPool &pool = ThreadPool::global())
+        {
+            forEach(count, chunkLength<fraction>(cost), [&](std::size_t i) { operation(out[i], a[i], b[i]); },
+                    pool);
+        }
+
+        /// Stores a[i] + b[i] in out[i].
+        template<int fraction, int exponent>
+        void add(VariableFloat<fraction, exponent> *out, const VariableFloat<fraction, exponent> *a,
+                 const VariableFloat<fraction, exponent> *b, std::size_t count,
+                 ThreadPool &pool = ThreadPool::global())
+        {
+            apply(out, a, b, count, VariableFloat<fraction, exponent>::add, BatchCost::Add, pool);
+        }
+
+        /// Stores a[i] - b[i] in out[i].
+        template<int fraction, int exponent>
+        void sub(VariableFloat<fraction, exponent> *out, const VariableFloat<fraction, exponent> *a,
+                 const VariableFloat<fraction, exponent> *b, std::size_t count,
+                 ThreadPool &pool = ThreadPool::global())
+        {
+            apply(out, a, b, count, VariableFloat<fraction, exponent>::subtract, BatchCost::Add, pool);
+        }
+
+        /// Stores a[i] * b[i] in out[i].
+        template<int fraction, int exponent>
+        void mul(VariableFloat<fraction, exponent> *out, const VariableFloat<fraction, exponent> *a,
+                 const VariableFloat<fraction, exponent> *b, std::size_t count,
+                 ThreadPool &pool = ThreadPool::global())
+        {
+            apply(out, a, b, count, VariableFloat<fraction, exponent>::multiply, BatchCost::Multiply, pool);
+        }
+
+        /// Stores a[i] / b[i] in out[i].
+        template<int fraction, int exponent>
+        void div(VariableFloat<fraction, exponent> *out, const VariableFloat<fraction, exponent> *a,
+                 const VariableFloat<fraction, exponent> *b, std::size_t count,
+                 ThreadPool &pool = ThreadPool::global())
+        {
+            apply(out, a, b, count, VariableFloat<fraction, exponent>::divide, BatchCost::Divide, pool);
+        }
+
+        /// Stores square root of a[i] in out[i].
+        template<int fraction, int exponent>
+        void sqrt(VariableFloat<fraction, exponent> *out, const VariableFloat<fraction, exponent> *a,
+                  std::size_t count, ThreadPool &pool = ThreadPool::global())
+        {
+            forEach(count, chunkLength<fraction>(BatchCost::SquareRoot), [&](std::size_t i)
+            {
+                VariableFloat<fraction, exponent>::sqrt(out[i], a[i]);
+            }, pool);
+        }
+
+        /// Stores a[i] * b[i] + c[i] (rounded once) in out[i].
+        template<int fraction, int exponent>
+        void fma(VariableFloat<fraction, exponent> *out, const VariableFloat<fraction, exponent> *a,
+                 const VariableFloat<fraction, exponent> *b, const VariableFloat<fraction, exponent> *c,
+                 std::size_t count, ThreadPool &pool = ThreadPool::global())
+        {
+            forEach(count, chunkLength<fraction>(BatchCost::Fma), [&](std::size_t i)
+            {
+                VariableFloat<fraction, exponent>::fma(out[i], a[i], b[i], c[i]);
+            }, pool);
+        }
+
+        /// Stores the sum of 'count' numbers, rounded once, in 'out'.
+        /// Every range is summed into its own KulischAccumulator and partial sums are merged exactly,
+        /// so the result does not depend on the thread count or on scheduling.
+        template<int fraction, int exponent>
+        void sum(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> *values,
+                 std::size_t count, ThreadPool &pool = ThreadPool::global())
+        {
+            KulischAccumulator<fraction, exponent> total;
+            std::mutex mutex;
+            pool.run(count, chunkLength<fraction>(BatchCost::Add), [&](std::size_t begin, std::size_t end)
+            {
+                KulischAccumulator<fraction, exponent> partial;
+                for (std::size_t i = begin; i < end; ++i) partial.add(values[i]);
+                std::lock_guard<std::mutex> lock(mutex);
+                total.merge(partial);
+            });
+            total.result(out);
+        }
+
+        /// Stores the dot product of 'count' element spans, rounded once, in 'out'.
+        /// Products are accumulated exactly like in 'sum'.
+        template<int fraction, int exponent>
+        void dot(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> *a,
+                 const VariableFloat<fraction, exponent> *b, std::size_t count,
+                 ThreadPool &pool = ThreadPool::global())
+        {
+            KulischAccumulator<fraction, exponent> total;
+            std::mutex mutex;
+            pool.run(count, chunkLength<fraction>(BatchCost::Multiply), [&](std::size_t begin, std::size_t end)
+            {
+                KulischAccumulator<fraction, exponent> partial;
+                for (std::size_t i = begin; i < end; ++i) partial.addProduct(a[i], b[i]);
+                std::lock_guard<std::mutex> lock(mutex);
+                total.merge(partial);
+            });
+            total.result(out);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#include "ScratchArena.h"
+
+#include <algorithm>
+
+ScratchArena::Frame::Frame(ScratchArena &owner) : arena(owner), chunk(owner.currentChunk), used(owner.currentUsed)
+{
+}
+
+ScratchArena::Frame::~Frame()
+{
+    arena.currentChunk = chunk;
+    arena.currentUsed = used;
+}
+
+u_int64_t *ScratchArena::Frame::allocate(std::size_t count)
+{
+    //Skip chunks that are too small for the request, add a new one if no chunk fits.
+    while (arena.currentChunk < arena.chunks.size() &&
+           arena.chunks[arena.currentChunk].size - arena.currentUsed < count)
+    {
+        ++arena.currentChunk;
+        arena.currentUsed = 0;
+    }
+    if (arena.currentChunk == arena.chunks.size())
+    {
+        std::size_t size = arena.chunks.empty() ? INITIAL_CHUNK : 2 * arena.chunks.back().size;
+        size = std::max(size, count);
+        arena.chunks.push_back(Chunk{std::unique_ptr<u_int64_t[]>(new u_int64_t[size]), size});
+        ++arena.chunkAllocations;
+    }
+
+    u_int64_t *result = arena.chunks[arena.currentChunk].data.get() + arena.currentUsed;
+    arena.currentUsed += count;
+    return result;
+}
+
+u_int64_t *ScratchArena::Frame::allocateZeroed(std::size_t count)
+{
+    u_int64_t *result = allocate(count);
+    std::fill(result, result + count, 0);
+    return result;
+}
+
+ScratchArena &ScratchArena::local()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
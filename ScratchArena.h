@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <sys/types.h>
+
+/// Scratch memory for temporary limb containers, released in LIFO order.
+/// Memory is taken from the global allocator only when the arena grows, so steady state
+/// arithmetic does not allocate. Each thread has its own default instance.
+class ScratchArena
+{
+public:
+    /// Scope of scratch allocations, everything allocated through a frame is released when it is destroyed.
+    /// Frames of one arena must be destroyed in reverse order of creation.
+    class Frame
+    {
+    public:
+        /// Opens a frame on the current thread's arena.
+        Frame() : Frame(ScratchArena::local()) {}
+
+        /// Opens a frame on a given arena.
+        /// \param owner - arena to allocate from.
+        explicit Frame(ScratchArena &owner);
+
+        /// Releases memory allocated through the frame.
+        ~Frame();
+
+        Frame(const Frame &) = delete;
+        Frame &operator=(const Frame &) = delete;
+
+        /// Allocates an uninitialized limb container.
+        /// \param count - limb count.
+        /// \return Pointer to container valid until the frame is destroyed.
+        u_int64_t *allocate(std::size_t count);
+
+        /// Allocates a limb container filled with zeros.
+        /// \param count - limb count.
+        /// \return Pointer to container valid until the frame is destroyed.
+        u_int64_t *allocateZeroed(std::size_t count);
+
+    private:
+        ScratchArena &arena;
+        std::size_t chunk;
+        std::size_t used;
+    };
+
+    /// ScratchArena default constructor (no memory is allocated until first use).
+    ScratchArena() = default;
+
+    ScratchArena(const ScratchArena &) = delete;
+    ScratchArena &operator=(const ScratchArena &) = delete;
+
+    /// Returns the current thread's arena.
+    /// \return Reference to thread local arena.
+    static ScratchArena &local();
+
+    /// Returns the number of chunks this arena has taken from the global allocator.
+    /// \return Chunk allocation count.
+    std::size_t getChunkAllocations() const { return chunkAllocations; }
+
+private:
+    /// Limb count of the first chunk, following chunks double in size.
+    static const std::size_t INITIAL_CHUNK = 4096;
+
+    /// Single block of memory taken from the global allocator.
+    struct Chunk
+    {
+        std::unique_ptr<u_int64_t[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Chunk> chunks;
+
+    /// Index of the chunk allocations are currently taken from.
+    std::size_t currentChunk = 0;
+
+    /// Limbs used in the current chunk.
+    std::size_t currentUsed = 0;
+
+    std::size_t chunkAllocations = 0;
+};
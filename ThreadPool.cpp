@@ -0,0 +1,156 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+//Thread count of the global pool, set by the build (0 - hardware concurrency).
+#ifndef OIAKFP_THREADS
+#define OIAKFP_THREADS 0
+#endif
+
+namespace
+{
+    //Set on threads that are executing a job, nested jobs run serially there.
+    thread_local bool insideJob = false;
+}
+
+ThreadPool::ThreadPool(u_int threads)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (u_int i = 0; i < threads; ++i) queues.emplace_back(new Queue());
+    for (u_int i = 1; i < threads; ++i) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    started.notify_all();
+    for (std::thread &worker : workers) worker.join();
+}
+
+ThreadPool &ThreadPool::global()
+{
+    static ThreadPool pool(OIAKFP_THREADS);
+    return pool;
+}
+
+void ThreadPool::run(std::size_t count, std::size_t chunkSize, const Job &body)
+{
+    if (count == 0) return;
+    chunkSize = std::max<std::size_t>(chunkSize, 1);
+    if (insideJob || workers.empty() || count <= chunkSize)
+    {
+        body(0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submitted(submission);
+
+    //Every thread starts with a contiguous share of indices.
+    const std::size_t threads = queues.size();
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        Range range{count * i / threads, count * (i + 1) / threads};
+        if (range.begin != range.end) queues[i]->ranges.push_back(range);
+    }
+    remaining = count;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &body;
+        chunk = chunkSize;
+        failure = nullptr;
+        active = (u_int) workers.size();
+        ++generation;
+    }
+    started.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return active == 0; });
+    job = nullptr;
+    if (failure) std::rethrow_exception(failure);
+}
+
+void ThreadPool::workerLoop(u_int index)
+{
+    u_int64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            started.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        work(index);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0) finished.notify_one();
+    }
+}
+
+void ThreadPool::work(u_int index)
+{
+    insideJob = true;
+    Range range;
+    while (remaining.load(std::memory_order_acquire) != 0)
+    {
+        if (!takeOwn(index, range) && !steal(index, range))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        //Keep splitting in half, the upper halves stay available for thieves.
+        while (range.end - range.begin > chunk)
+        {
+            std::size_t middle = range.begin + (range.end - range.begin) / 2;
+            {
+                std::lock_guard<std::mutex> lock(queues[index]->mutex);
+                queues[index]->ranges.push_back(Range{middle, range.end});
+            }
+            range.end = middle;
+        }
+
+        try
+        {
+            (*job)(range.begin, range.end);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) failure = std::current_exception();
+        }
+        remaining.fetch_sub(range.end - range.begin, std::memory_order_acq_rel);
+    }
+    insideJob = false;
+}
+
+bool ThreadPool::takeOwn(u_int index, Range &range)
+{
+    Queue &queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty()) return false;
+    range = queue.ranges.back();
+    queue.ranges.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(u_int index, Range &range)
+{
+    const u_int threads = (u_int) queues.size();
+    for (u_int i = 1; i < threads; ++i)
+    {
+        Queue &queue = *queues[(index + i) % threads];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.ranges.empty()) continue;
+        range = queue.ranges.front();
+        queue.ranges.pop_front();
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+/// Work stealing thread pool running index ranges of a single job at a time.
+/// Every thread (the calling one included) owns a queue of ranges. A thread splits ranges longer than
+/// the chunk size in half and keeps the halves in its own queue, idle threads steal the oldest (largest)
+/// ranges from queues of others, so uneven element costs are balanced without central scheduling.
+class ThreadPool
+{
+public:
+    /// Body of a job, called with [begin, end) ranges of indices.
+    typedef std::function<void(std::size_t, std::size_t)> Job;
+
+    /// Creates a pool.
+    /// \param threads - thread count including the calling thread (0 - hardware concurrency).
+    explicit ThreadPool(u_int threads = 0);
+
+    /// Stops and joins worker threads.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /// Returns the pool shared by default by parallel batch operations and large multiplications.
+    /// Its thread count is set at build time with OIAKFP_THREADS (0 - hardware concurrency).
+    /// \return Reference to the global pool.
+    static ThreadPool &global();
+
+    /// Returns thread count including the calling thread.
+    /// \return Thread count.
+    u_int getThreadCount() const { return (u_int) queues.size(); }
+
+    /// Runs a job over indices 0 .. 'count' - 1 and waits until it is finished.
+    /// Calls made from inside a job of any pool run serially on the calling thread.
+    /// The first exception thrown by the job is rethrown after all ranges are finished.
+    /// \param count - index count.
+    /// \param chunk - length of ranges that are no longer split (at least 1).
+    /// \param job - body called with disjoint ranges covering all indices.
+    void run(std::size_t count, std::size_t chunk, const Job &job);
+
+private:
+    /// Range of indices [begin, end).
+    struct Range
+    {
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    /// Range queue owned by a single thread, the owner works at the back, thieves take from the front.
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    /// Serializes jobs submitted by different threads.
+    std::mutex submission;
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+
+    /// Current job and its chunk length.
+    const Job *job = nullptr;
+    std::size_t chunk = 1;
+
+    /// Incremented for every job, so that workers notice a new one.
+    u_int64_t generation = 0;
+
+    /// Workers that are still taking part in the current job.
+    u_int active = 0;
+
+    bool stopping = false;
+
+    /// Indices of the current job that have not been processed yet.
+    std::atomic<std::size_t> remaining{0};
+
+    /// First exception thrown by the current job.
+    std::exception_ptr failure;
+
+    /// Worker thread main loop.
+    /// \param index - index of the worker's queue.
+    void workerLoop(u_int index);
+
+    /// Processes ranges of the current job until all of them are finished.
+    /// \param index - index of the calling thread's queue.
+    void work(u_int index);
+
+    /// Takes a range from the back of a thread's own queue.
+    /// \param index - queue index.
+    /// \param range - taken range.
+    /// \return 1 - if a range was taken, 0 - if the queue was empty.
+    bool takeOwn(u_int index, Range &range);
+
+    /// Takes a range from the front of another thread's queue.
+    /// \param index - index of the thief's queue (searching starts after it).
+    /// \param range - stolen range.
+    /// \return 1 - if a range was stolen, 0 - if all queues were empty.
+    bool steal(u_int index, Range &range);
+};
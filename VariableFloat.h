@@ -2,9 +2,16 @@
 
 #include <iostream>
 #include <vector>
+#include <array>
 #include <iomanip>
+#include <cstring>
+#include <type_traits>
 
 #include "ByteArray.h"
+#include "LimbArray.h"
+#include "NativeArithmetic.h"
+#include "MultiDouble.h"
+#include "WorkingExponent.h"
 
 template<int fraction, int exponent>
 /// Variable precision floating point number library.
@@ -12,6 +19,29 @@ template<int fraction, int exponent>
 /// \tparam exponent - exponent bit count.
 class VariableFloat
 {
+public:
+    /// Exponent size in bytes (used by text representation).
+    static constexpr u_int exponentSize = (exponent / 8) + 1;
+
+    /// Fraction size in bytes (used by text representation).
+    static constexpr u_int fractionSize = (fraction / 8) + 1;
+
+    /// Exponent size in limbs.
+    static constexpr u_int exponentLimbs = (exponent / 64) + 1;
+
+    /// Fraction size in limbs (fraction bits and the hidden '1').
+    static constexpr u_int fractionLimbs = (fraction / 64) + 1;
+
+    /// Fixed-size exponent limb container.
+    typedef std::array<u_int64_t, exponentLimbs> ExponentLimbs;
+
+    /// Signed exponent used during computation (long long for exponents of up to 62 bits, otherwise two's complement
+    /// limbs with one additional limb).
+    typedef WorkingExponent<exponent> ExponentWork;
+
+    /// Fixed-size fraction limb container.
+    typedef std::array<u_int64_t, fractionLimbs> FractionLimbs;
+
 private:
     //Float and double constants.
     static const u_int DOUBLE_EXPONENT = 11;
@@ -19,26 +49,24 @@ private:
     static const u_int FLOAT_EXPONENT = 8;
     static const u_int FLOAT_FRACTION = 23;
 
-    /// Bias vector.
-    std::vector<u_char> biasContainer;
+    /// Bias container, shared by all numbers of this representation.
+    static constexpr ExponentLimbs biasContainer = LimbArray::createMask<exponentLimbs>(0, exponent - 1);
 
     /// Maximum exponent value for current representation.
-    std::vector<u_char> maxExponent;
+    static constexpr ExponentLimbs maxExponent = LimbArray::createMask<exponentLimbs>(1, exponent);
 
     /// Minimum exponent value for current representation.
-    std::vector<u_char> minExponent;
-
-    /// Exponent byte container.
-    std::vector<u_char> exponentContainer;
+    static constexpr ExponentLimbs minExponent = LimbArray::createMask<exponentLimbs>(0, 1);
 
-    /// Fraction byte container.
-    std::vector<u_char> fractionContainer;
+    /// Exponent value reserved for infinity and NaN.
+    static constexpr ExponentLimbs infinityExponent = LimbArray::createMask<exponentLimbs>(0, exponent);
 
-    /// Exponent size in bytes.
-    u_int exponentSize{};
+    /// Biased exponent limb container.
+    ExponentLimbs exponentContainer{};
 
-    /// Fraction size in bytes.
-    u_int fractionSize{};
+    /// Fraction limb container. Holds the hidden '1' followed by fraction bits,
+    /// aligned to the highest order bit of the container.
+    FractionLimbs fractionContainer{};
 
     /// Sign bit of a number.
     bool sign{};
@@ -49,25 +77,52 @@ private:
     std::vector<u_char> hexStringToBytes(const std::string &input);
 
     /// Checks whether current exponent will lead to an overflow or underflow.
-    /// \param currentExponent - current exponent byte container.
+    /// \param currentExponent - current exponent working container.
     /// \return 1 if overflow, -1 if underflow, otherwise 0.
-    int checkForOverflow(std::vector<u_char> &currentExponent);
-
-    /// Rounds the fraction using 'round to nearest' method.
-    /// \param currentFraction - current fraction byte container.
-    /// \return Reference to a modified byte container.
-    std::vector<u_char> &roundFraction(std::vector<u_char> &currentFraction);
+    static int checkForOverflow(const ExponentWork &currentExponent);
+
+    /// Sets the number from an IEEE 754 binary representation.
+    /// \param numberSign - sign bit.
+    /// \param numberExponent - biased exponent field.
+    /// \param numberFraction - fraction field.
+    /// \param exponentBits - exponent field bit count.
+    /// \param fractionBits - fraction field bit count.
+    void setFromBinary(bool numberSign, u_int64_t numberExponent, u_int64_t numberFraction,
+                       u_int exponentBits, u_int fractionBits);
+
+    /// Arithmetic used instead of limb arithmetic when selected at compile time: multi-double (opt-in),
+    /// otherwise native integer arithmetic of the format.
+    typedef typename std::conditional<MultiDoubleArithmetic<fraction, exponent>::ENABLED,
+            MultiDoubleArithmetic<fraction, exponent>, NativeArithmetic<fraction, exponent>>::type Backend;
+
+    /// std::true_type if the format has a backend.
+    typedef std::integral_constant<bool, Backend::ENABLED> BackendPath;
+
+    /// Limb arithmetic implementations of add, multiply, divide and sqrt.
+    static void addSelected(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                            const VariableFloat<fraction, exponent> &n2, std::false_type);
+    static void multiplySelected(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                                 const VariableFloat<fraction, exponent> &n2, std::false_type);
+    static void divideSelected(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                               const VariableFloat<fraction, exponent> &n2, std::false_type);
+    static void sqrtSelected(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &number,
+                             std::false_type);
+
+    /// Backend implementations, zero, infinity and NaN operands are left to limb arithmetic.
+    static void addSelected(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                            const VariableFloat<fraction, exponent> &n2, std::true_type);
+    static void multiplySelected(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                                 const VariableFloat<fraction, exponent> &n2, std::true_type);
+    static void divideSelected(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                               const VariableFloat<fraction, exponent> &n2, std::true_type);
+    static void sqrtSelected(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &number,
+                             std::true_type);
 
 public:
     /// (One day) Private constructor for initializing containers.
     /// Made public because of usages in arrays, vectors.
     VariableFloat();
 
-    /// Creates a bias vector for specified bit exponent bit count.
-    /// \param customExponent - exponent bit count.
-    /// \return Bias vector for specified bit count.
-    std::vector<u_char> createBiasContainerForExponent(int customExponent);
-
     /// VariableFloat single precision constructor.
     /// \param number - constructor float argument.
     explicit VariableFloat(float number);
@@ -84,24 +139,97 @@ public:
     /// VariableFloat destructor.
     ~VariableFloat() = default;
 
-    /// VariableFloat copy constructor.
-    VariableFloat(const VariableFloat<fraction, exponent> &number);
+    /// VariableFloat copy constructor (all containers are stored inline).
+    VariableFloat(const VariableFloat<fraction, exponent> &number) noexcept = default;
+
+    /// VariableFloat move constructor (a plain copy of inline containers, no allocation).
+    VariableFloat(VariableFloat<fraction, exponent> &&number) noexcept = default;
+
+    /// VariableFloat copy assignment operator (overwrites containers in place).
+    VariableFloat<fraction, exponent> &operator=(const VariableFloat<fraction, exponent> &number) noexcept = default;
+
+    /// VariableFloat move assignment operator (overwrites containers in place).
+    VariableFloat<fraction, exponent> &operator=(VariableFloat<fraction, exponent> &&number) noexcept = default;
 
-    /// Adds 'operand' to current object.
+    /// Adds 'operand' to current object (in place, without a temporary).
     /// \param operand - reference to VariableFloat object with same template parameters.
-    void operator+=(const VariableFloat<fraction, exponent> &operand) { *this = *this + operand; }
+    void operator+=(const VariableFloat<fraction, exponent> &operand) { add(*this, *this, operand); }
 
-    /// Subtracts 'operand' from current object.
+    /// Subtracts 'operand' from current object (in place, without a temporary).
     /// \param operand - reference to VariableFloat object with same template parameters.
-    void operator-=(const VariableFloat<fraction, exponent> &operand) { *this = *this - operand; }
+    void operator-=(const VariableFloat<fraction, exponent> &operand) { subtract(*this, *this, operand); }
 
-    /// Multiplies current object by 'operand'.
+    /// Multiplies current object by 'operand' (in place, without a temporary).
     /// \param operand - reference to VariableFloat object with same template parameters.
-    void operator*=(const VariableFloat<fraction, exponent> &operand) { *this = *this * operand; }
+    void operator*=(const VariableFloat<fraction, exponent> &operand) { multiply(*this, *this, operand); }
 
-    /// Divides current object by 'operand'.
+    /// Divides current object by 'operand' (in place, without a temporary).
     /// \param operand - reference to VariableFloat object with same template parameters.
-    void operator/=(const VariableFloat<fraction, exponent> &operand) { *this = *this / operand; }
+    void operator/=(const VariableFloat<fraction, exponent> &operand) { divide(*this, *this, operand); }
+
+    /// Adds two numbers and stores the sum in 'result'.
+    /// Working values are kept on the stack, so 'result' may be the same object as any operand.
+    /// \param result - sum destination.
+    /// \param n1 - first addition operand.
+    /// \param n2 - second addition operand.
+    static void add(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                    const VariableFloat<fraction, exponent> &n2)
+    {
+        addSelected(result, n1, n2, BackendPath());
+    }
+
+    /// Subtracts two numbers and stores the difference in 'result' (which may be the same object as any operand).
+    /// \param result - difference destination.
+    /// \param n1 - first subtraction operand.
+    /// \param n2 - second subtraction operand.
+    static void subtract(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                         const VariableFloat<fraction, exponent> &n2);
+
+    /// Multiplies two numbers and stores the product in 'result' (which may be the same object as any operand).
+    /// \param result - product destination.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    static void multiply(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                         const VariableFloat<fraction, exponent> &n2)
+    {
+        multiplySelected(result, n1, n2, BackendPath());
+    }
+
+    /// Divides two numbers and stores the quotient in 'result' (which may be the same object as any operand).
+    /// \param result - quotient destination.
+    /// \param n1 - dividend.
+    /// \param n2 - divisor.
+    static void divide(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                       const VariableFloat<fraction, exponent> &n2)
+    {
+        divideSelected(result, n1, n2, BackendPath());
+    }
+
+    /// Computes n1 * n2 + n3 with a single rounding and stores it in 'result'
+    /// (which may be the same object as any operand).
+    /// \param result - destination.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    /// \param n3 - addition operand.
+    static void fma(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &n1,
+                    const VariableFloat<fraction, exponent> &n2, const VariableFloat<fraction, exponent> &n3);
+
+    /// Computes n1 * n2 + n3 with a single rounding.
+    /// \param n1 - first multiplication operand.
+    /// \param n2 - second multiplication operand.
+    /// \param n3 - addition operand.
+    /// \return Fused multiply-add result.
+    static VariableFloat<fraction, exponent> fma(const VariableFloat<fraction, exponent> &n1,
+                                                 const VariableFloat<fraction, exponent> &n2,
+                                                 const VariableFloat<fraction, exponent> &n3);
+
+    /// Computes a square root of a given number and stores it in 'result' (which may be the same object as 'number').
+    /// \param result - square root destination.
+    /// \param number - number to find the square root of.
+    static void sqrt(VariableFloat<fraction, exponent> &result, const VariableFloat<fraction, exponent> &number)
+    {
+        sqrtSelected(result, number, BackendPath());
+    }
 
     /// Computes a square root of a given number.
     /// \param number - number to find the square root of.
@@ -120,6 +248,10 @@ public:
     /// \return true if NaN, otherwise false.
     bool isNan() const;
 
+    /// Checks whether currently stored number is zero, infinity or NaN.
+    /// \return true if the exponent is all zeros or all ones, otherwise false.
+    bool isSpecial() const;
+
     /// Checks whether currently stored number is infinity (number is too big).
     /// \return true if Infinity, otherwise false.
     bool isInfinity() const;
@@ -132,55 +264,47 @@ public:
     /// \return true if +Infinity, otherwise false.
     bool isPositiveInfinity() const;
 
-    /// Returns a reference to an object's maxExponent container.
-    /// \return reference to an object's maxExponent container.
-    const std::vector<u_char> &getMaxExponent() const { return maxExponent; }
+    /// Returns a reference to maxExponent container.
+    /// \return reference to maxExponent container.
+    static const ExponentLimbs &getMaxExponent() { return maxExponent; }
 
-    /// Returns a reference to an object's minExponent container.
-    /// \return reference to an object's minExponent container.
-    const std::vector<u_char> &getMinExponent() const { return minExponent; }
+    /// Returns a reference to minExponent container.
+    /// \return reference to minExponent container.
+    static const ExponentLimbs &getMinExponent() { return minExponent; }
 
     /// Returns a reference to an object's fraction container.
     /// \return reference to an object's fraction container
-    const std::vector<u_char> &getFractionContainer() const { return fractionContainer; }
+    const FractionLimbs &getFractionContainer() const { return fractionContainer; }
 
     /// Returns a reference to an object's exponent container.
     /// \return reference to an object's exponent container
-    const std::vector<u_char> &getExponentContainer() const { return exponentContainer; }
+    const ExponentLimbs &getExponentContainer() const { return exponentContainer; }
 
     /// Returns sign of a number.
-    /// \return true if positive, otherwise false.
+    /// \return true if negative, otherwise false.
     bool getSign() const { return sign; }
 
-    /// Sets fraction container using the argument's vector.
-    /// \param f - container to be set.
-    void setFractionContainer(std::vector<u_char>& f)
-    {
-        fractionContainer = roundFraction(f);
-        int difference = fractionContainer.size() - fractionSize;
-        for (int i = 0; i < difference; i++) fractionContainer.pop_back();
-    }
+    /// Sets the sign of a number.
+    /// \param s - sign to be set.
+    void setSign(bool s) { sign = s; }
 
-    /// Sets exponent container using the argument's vector.
-    /// \param e - container to be set
-    void setExponentContainer(std::vector<u_char>& e)
+    /// Sets the whole representation of a number (containers must hold a valid encoding).
+    /// \param numberSign - sign to be set.
+    /// \param numberExponent - biased exponent container.
+    /// \param numberFraction - fraction container (with the hidden '1' unless zero, infinity or NaN).
+    void setContainers(bool numberSign, const ExponentLimbs &numberExponent, const FractionLimbs &numberFraction)
     {
-        switch (checkForOverflow(e))
-        {
-            case 1:
-                setInfinity(getSign());
-                break;
-            case -1:
-                setZero(getSign());
-                break;
-            default:
-                exponentContainer = e;
-        }
+        sign = numberSign;
+        exponentContainer = numberExponent;
+        fractionContainer = numberFraction;
     }
 
-    /// Sets the sign of a number.
-    /// \param s - sign to be set.
-    void setSign(bool s) { sign = s; }
+    /// Normalizes, rounds and stores the result of an arithmetic operation.
+    /// \param resultSign - sign of the result.
+    /// \param resultExponent - biased exponent of the highest order bit of 'significand'.
+    /// \param significand - unnormalized result significand, lowest order bit must include the sticky bit.
+    /// \param size - significand limb count (at least 'fractionLimbs').
+    void setResult(bool resultSign, ExponentWork &resultExponent, u_int64_t *significand, u_int size);
 
     /// Sets the object's number representation to zero.
     /// \param setSign - if true then negative, otherwise positive.
@@ -193,9 +317,23 @@ public:
     /// Sets the object's number representation to NaN.
     void setNan();
 
-    /// Returns a reference to an object's bias container.
+    /// Returns a reference to bias container.
     /// \return Reference to a bias container.
-    const std::vector<u_char> &getBias() const { return biasContainer; }
+    static const ExponentLimbs &getBias() { return biasContainer; }
+
+    /// Returns a reference to the exponent of infinity and NaN.
+    /// \return Reference to an exponent container with all bits set.
+    static const ExponentLimbs &getInfinityExponent() { return infinityExponent; }
+
+    /// Creates an exponent working container from a stored exponent.
+    /// \param source - stored exponent container.
+    /// \return Zero extended exponent working container.
+    static ExponentWork loadExponent(const ExponentLimbs &source);
+
+    /// Adds a signed value to an exponent working container.
+    /// \param currentExponent - exponent working container.
+    /// \param value - value to be added.
+    static void adjustExponent(ExponentWork &currentExponent, long long value);
 
     /// Returns object's string representation.
     /// \return Object's string representation.
@@ -204,457 +342,542 @@ public:
 };
 
 template<int fraction, int exponent>
-VariableFloat<fraction,exponent>::VariableFloat()
-{
-    sign = 0;
-    exponentSize = (exponent / 8) + 1;
-    fractionSize = (fraction / 8) + 1;
-
-    for (unsigned int i = 0; i < exponentSize; ++i)
-    {
-        biasContainer.push_back(255);
-        maxExponent.push_back(255);
-        minExponent.push_back(0);
-    }
+constexpr u_int VariableFloat<fraction, exponent>::exponentSize;
 
-    int shiftCount = exponentSize * 8 - (exponent - 1);
-    ByteArray::shiftVectorRight(biasContainer, shiftCount);
+template<int fraction, int exponent>
+constexpr u_int VariableFloat<fraction, exponent>::fractionSize;
 
-    shiftCount--;
-    ByteArray::shiftVectorRight(maxExponent, shiftCount);
-    ByteArray::setBit(maxExponent, exponentSize * 8 - 1, false);
-    ByteArray::setBit(minExponent, exponentSize * 8 - 1, true);
-}
+template<int fraction, int exponent>
+constexpr u_int VariableFloat<fraction, exponent>::exponentLimbs;
 
 template<int fraction, int exponent>
-VariableFloat<fraction, exponent>::VariableFloat(const VariableFloat<fraction, exponent> &number) : VariableFloat()
-{
-    sign = number.sign;
-    for (auto byte : number.exponentContainer) exponentContainer.push_back(byte);
-    for (auto byte : number.fractionContainer) fractionContainer.push_back(byte);
-    for (auto byte : number.biasContainer) biasContainer.push_back(byte);
-    for (auto byte : number.maxExponent) maxExponent.push_back(byte);
-    for (auto byte : number.minExponent) minExponent.push_back(byte);
-}
+constexpr u_int VariableFloat<fraction, exponent>::fractionLimbs;
 
 template<int fraction, int exponent>
-VariableFloat<fraction, exponent>::VariableFloat(float number) : VariableFloat()
-{
-    u_int floatBytes = *((u_int *) &number);
+constexpr typename VariableFloat<fraction, exponent>::ExponentLimbs VariableFloat<fraction, exponent>::biasContainer;
 
-    //To get the exponent, left shift bits by one to get rid of the sign bit
-    //and then right shift by float mantissa bit size.
-    u_int floatExponent = floatBytes << 1;
-    floatExponent >>= 1;
-    sign = ((u_int) floatExponent ^ floatBytes) > 0;
-    floatExponent >>= FLOAT_FRACTION;
+template<int fraction, int exponent>
+constexpr typename VariableFloat<fraction, exponent>::ExponentLimbs VariableFloat<fraction, exponent>::maxExponent;
 
-    //We need to convert our extracted exponent to template implementation.
-    int byteCount = exponent >= FLOAT_EXPONENT ? (FLOAT_EXPONENT / 8) + 1 : exponentSize;
-    ByteArray::putBytesExponent(((u_char *)&floatExponent), byteCount, exponentContainer);
-    for (unsigned int i = 0; i < (exponentSize - byteCount); i++)
-        exponentContainer.insert(exponentContainer.begin(), 0);
+template<int fraction, int exponent>
+constexpr typename VariableFloat<fraction, exponent>::ExponentLimbs VariableFloat<fraction, exponent>::minExponent;
 
-    std::vector<u_char> floatBias = createBiasContainerForExponent(FLOAT_EXPONENT);
-    ByteArray::subtractBytes(exponentContainer, floatBias);
-    ByteArray::addBytes(exponentContainer, biasContainer);
+template<int fraction, int exponent>
+constexpr typename VariableFloat<fraction, exponent>::ExponentLimbs VariableFloat<fraction, exponent>::infinityExponent;
 
-    u_int floatFraction = floatBytes << (FLOAT_EXPONENT + 1);
-    floatFraction >>= FLOAT_EXPONENT;
-    byteCount = fraction >= FLOAT_FRACTION ? (FLOAT_FRACTION / 8) + 1 : fractionSize;
-    ByteArray::putBytesFraction(((u_char *) &floatFraction), 3, byteCount, fractionContainer);
-    for (unsigned int i = 0; i < (fractionSize - byteCount); i++) fractionContainer.push_back(0);
+template<int fraction, int exponent>
+VariableFloat<fraction,exponent>::VariableFloat()
+{
+    static_assert(std::is_trivially_copyable<VariableFloat<fraction, exponent>>::value,
+                  "VariableFloat must stay trivially copyable.");
+    static_assert(std::is_nothrow_move_constructible<VariableFloat<fraction, exponent>>::value &&
+                  std::is_nothrow_move_assignable<VariableFloat<fraction, exponent>>::value,
+                  "VariableFloat temporaries must be movable without allocation.");
 }
 
 template<int fraction, int exponent>
-VariableFloat<fraction, exponent>::VariableFloat(double number) : VariableFloat()
+VariableFloat<fraction, exponent>::VariableFloat(float number)
 {
-    u_int64_t doubleBytes = *((uint64_t *) &number);
+    u_int floatBytes;
+    std::memcpy(&floatBytes, &number, sizeof(floatBytes));
 
-    //To get the exponent, left shift bits by one to get rid of the sign bit
-    //and then right shift by double mantissa bit size.
-    u_int64_t doubleExponent = doubleBytes << 1;
-    doubleExponent >>= 1;
-    sign = ((u_int64_t) doubleExponent ^ doubleBytes) > 0;
-    doubleExponent >>= DOUBLE_FRACTION;
-
-    //We need to convert our extracted exponent to template implementation.
-    int byteCount = exponent >= DOUBLE_EXPONENT ? (DOUBLE_EXPONENT / 8) + 1 : exponentSize;
-    ByteArray::putBytesExponent(((u_char *) &doubleExponent), byteCount, exponentContainer);
-    for (unsigned int i = 0; i < (exponentSize - byteCount); i++)
-        exponentContainer.insert(exponentContainer.begin(), 0);
+    //Extract sign, exponent and fraction fields.
+    u_int floatExponent = (floatBytes >> FLOAT_FRACTION) & ((1u << FLOAT_EXPONENT) - 1);
+    u_int floatFraction = floatBytes & ((1u << FLOAT_FRACTION) - 1);
+    setFromBinary((floatBytes >> 31) != 0, floatExponent, floatFraction, FLOAT_EXPONENT, FLOAT_FRACTION);
+}
 
-    std::vector<u_char> doubleBias = createBiasContainerForExponent(DOUBLE_EXPONENT);
-    ByteArray::subtractBytes(exponentContainer, doubleBias);
-    ByteArray::addBytes(exponentContainer, biasContainer);
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent>::VariableFloat(double number)
+{
+    u_int64_t doubleBytes;
+    std::memcpy(&doubleBytes, &number, sizeof(doubleBytes));
 
-    u_int64_t doubleFraction = doubleBytes << (DOUBLE_EXPONENT + 1);
-    doubleFraction >>= DOUBLE_EXPONENT - 3;
-    byteCount = fraction >= DOUBLE_FRACTION ? (DOUBLE_FRACTION / 8) + 1 : fractionSize;
-    ByteArray::putBytesFraction(((u_char *) &doubleFraction), 7, byteCount, fractionContainer);
-    for (unsigned int i = 0; i < (fractionSize - byteCount); i++) fractionContainer.push_back(0);
+    //Extract sign, exponent and fraction fields.
+    u_int64_t doubleExponent = (doubleBytes >> DOUBLE_FRACTION) & ((1ull << DOUBLE_EXPONENT) - 1);
+    u_int64_t doubleFraction = doubleBytes & ((1ull << DOUBLE_FRACTION) - 1);
+    setFromBinary((doubleBytes >> 63) != 0, doubleExponent, doubleFraction, DOUBLE_EXPONENT, DOUBLE_FRACTION);
 }
 
 template<int fraction, int exponent>
 VariableFloat<fraction, exponent>::VariableFloat(bool sign, const std::string &exponentRep,
-                                                 const std::string &fractionRep) : VariableFloat()
+                                                 const std::string &fractionRep)
 {
+    //Exponent is given as an unbiased value (modulo exponent byte size).
+    typename ExponentWork::Limbs resultExponent{};
+    ByteArray::bytesToLimbs(hexStringToBytes(exponentRep), resultExponent.data(), exponentLimbs + 1);
+    LimbArray::addLimbs(resultExponent.data(), loadExponent(biasContainer).toLimbs().data(), exponentLimbs + 1);
+    u_int unusedBits = (exponentLimbs + 1) * 64 - exponentSize * 8;
+    LimbArray::shiftLeft(resultExponent.data(), exponentLimbs + 1, unusedBits);
+    LimbArray::shiftRight(resultExponent.data(), exponentLimbs + 1, unusedBits);
+
     this->sign = sign;
-    exponentContainer = hexStringToBytes(exponentRep);
-    int byteCount = exponentContainer.size();
-    for (unsigned int i = 0; i < (exponentSize - byteCount); i++) exponentContainer.insert(exponentContainer.begin(), 0);
-    ByteArray::addBytes(exponentContainer, biasContainer);
-    fractionContainer = hexStringToBytes(fractionRep);
-    byteCount = fractionContainer.size();
-    for (unsigned int i = 0; i < (fractionSize - byteCount); i++) fractionContainer.push_back(0);
+    if (LimbArray::checkIfZero(resultExponent.data(), exponentLimbs + 1)) return;
+    std::copy(resultExponent.begin(), resultExponent.begin() + exponentLimbs, exponentContainer.begin());
+
+    //Fraction is given in bytes aligned to the highest order bit, add hidden '1' and align to the container.
+    std::array<u_int64_t, fractionLimbs + 1> resultFraction{};
+    ByteArray::bytesToLimbs(hexStringToBytes(fractionRep), resultFraction.data(), fractionLimbs + 1);
+    LimbArray::shiftRight(resultFraction.data(), fractionLimbs + 1, fractionSize * 8 - fraction);
+    resultFraction[fraction / 64] |= (u_int64_t) 1 << (fraction % 64);
+    LimbArray::shiftLeft(resultFraction.data(), fractionLimbs + 1, fractionLimbs * 64 - fraction - 1);
+    std::copy(resultFraction.begin(), resultFraction.begin() + fractionLimbs, fractionContainer.begin());
 }
 
 template<int fraction, int exponent>
-VariableFloat<fraction, exponent> operator + (const VariableFloat<fraction, exponent> &n1, const VariableFloat<fraction, exponent> &n2)
+void VariableFloat<fraction, exponent>::addSelected(VariableFloat<fraction, exponent> &result,
+                                                    const VariableFloat<fraction, exponent> &n1,
+                                                    const VariableFloat<fraction, exponent> &n2, std::false_type)
 {
-    VariableFloat<fraction, exponent> ret(0.0);
-    std::vector<u_char> retExponent;
+    typedef VariableFloat<fraction, exponent> Float;
+    const u_int size = Float::fractionLimbs + 1;
 
-    bool sameSigns = n1.getSign() == n2.getSign();
+    //Check for NaN, infinity or zero.
+    if (n1.isNan() || n2.isNan())
+    {
+        result.setNan();
+        return;
+    }
+    else if (n1.isInfinity() || n2.isInfinity())
+    {
+        if (n1.isInfinity() && n2.isInfinity() && n1.getSign() != n2.getSign()) result.setNan();
+        else result.setInfinity(n1.isInfinity() ? n1.getSign() : n2.getSign());
+        return;
+    }
+    else if (n2.isZero())
+    {
+        if (!n1.isZero()) result = n1;
+        else result.setZero(n1.getSign() && n2.getSign());
+        return;
+    }
+    else if (n1.isZero())
+    {
+        result = n2;
+        return;
+    }
 
+    bool sameSigns = n1.getSign() == n2.getSign();
 
     //|n1| > |n2|
-    ret.setSign(n1.getSign());
-    std::vector<u_char> sub = n1.getExponentContainer();
-    retExponent = n1.getExponentContainer();
-    std::vector<u_char> higherFrac = n1.getFractionContainer();
-    std::vector<u_char> lowerFrac = n2.getFractionContainer();
-
-    bool carry = ByteArray::subtractBytes(sub, n2.getExponentContainer());
+    const Float *higher = &n1;
+    const Float *lower = &n2;
+    int comparision = Float::loadExponent(n1.getExponentContainer()).compare(n2.getExponentContainer());
+    if (comparision == 0)
+        comparision = LimbArray::compare(n1.getFractionContainer().data(), n2.getFractionContainer().data(),
+                                         Float::fractionLimbs);
 
     //|n2| > |n1|
-    if (carry)
+    if (comparision < 0)
     {
-        ret.setSign(n2.getSign());
-        sub = n2.getExponentContainer();
-        retExponent = n2.getExponentContainer();
-        higherFrac = n2.getFractionContainer();
-        lowerFrac = n1.getFractionContainer();
-        ByteArray::subtractBytes(sub, n1.getExponentContainer());
+        higher = &n2;
+        lower = &n1;
     }
 
-    //Add hidden '1'.
-    higherFrac.push_back(0);
-    ByteArray::shiftVectorRight(higherFrac, 1);
-    ByteArray::setBit(higherFrac, 0, true);
+    typename Float::ExponentWork sub = Float::loadExponent(higher->getExponentContainer());
+    sub.subtract(Float::loadExponent(lower->getExponentContainer()));
 
-    lowerFrac.push_back(0);
-    ByteArray::shiftVectorRight(lowerFrac, 1);
-    ByteArray::setBit(lowerFrac, 0, true);
+    //Fractions get one additional lowest order limb for guard bits.
+    std::array<u_int64_t, size> higherFrac{};
+    std::array<u_int64_t, size> lowerFrac{};
+    std::copy(higher->getFractionContainer().begin(), higher->getFractionContainer().end(), higherFrac.begin() + 1);
+    std::copy(lower->getFractionContainer().begin(), lower->getFractionContainer().end(), lowerFrac.begin() + 1);
 
-    //Shift fraction for lower number.
-    while (!ByteArray::checkIfZero(sub))
+    //Align fraction of lower number with a single shift, bits shifted out are kept as a sticky bit.
+    //If exponent difference exceeds the fraction width, lower number only contributes a sticky bit.
+    bool sticky;
+    if (!sub.isBelow(size * 64))
     {
-        ByteArray::subtractBytes(sub, ByteArray::createOne(sub.size()));
-        ByteArray::shiftVectorRight(lowerFrac, 1);
+        lowerFrac.fill(0);
+        sticky = true;
     }
+    else sticky = LimbArray::shiftRightSticky(lowerFrac.data(), size, (u_int) sub.getLow());
+    lowerFrac[0] |= sticky;
 
-    int pointPos = higherFrac.size()*8 - ByteArray::findHighestOrderOnePosition(higherFrac) - 1;
-
-    //For overflow.
+    typename Float::ExponentWork retExponent = Float::loadExponent(higher->getExponentContainer());
     if (sameSigns)
     {
-        u_char carrySameSigns = ByteArray::addBytesEqualSize(higherFrac, lowerFrac);
-        higherFrac.insert(higherFrac.begin(), carrySameSigns);
+        //For overflow.
+        if (LimbArray::addLimbs(higherFrac.data(), lowerFrac.data(), size))
+        {
+            sticky = higherFrac[0] & 1;
+            LimbArray::shiftRight(higherFrac.data(), size, 1);
+            higherFrac[0] |= sticky;
+            higherFrac[size - 1] |= (u_int64_t) 1 << 63;
+            retExponent.add(1);
+        }
     }
     else
     {
         //There will be no overflow. 'higherFrac' is always bigger than 'lowerFrac'.
-        ByteArray::subtractBytes(higherFrac, lowerFrac);
-    }
-
-
-    int newPointPos = higherFrac.size()*8 - ByteArray::findHighestOrderOnePosition(higherFrac) - 1;
-    int shiftDirection = pointPos - newPointPos;
-    if (shiftDirection < 0)
-    {
-        ByteArray::shiftVectorRight(higherFrac, -shiftDirection);
-        ByteArray::addBytes(retExponent, ByteArray::createValue(retExponent.size(), -shiftDirection));
-    }
-    else
-    {
-        ByteArray::shiftVectorLeft(higherFrac, shiftDirection);
-        ByteArray::subtractBytes(retExponent, ByteArray::createValue(retExponent.size(), shiftDirection));
+        LimbArray::subtractLimbs(higherFrac.data(), lowerFrac.data(), size);
+        if (LimbArray::checkIfZero(higherFrac.data(), size))
+        {
+            result.setZero(false);
+            return;
+        }
     }
 
-    //Remove what has been pushed before.
-    higherFrac.erase(higherFrac.end() - 1);
-
-    //Remove only if it was added in previous operations. (if same signs)
-    if (sameSigns)
-        higherFrac.erase(higherFrac.begin());
-
-    //Shift back (remove leading '1').
-    ByteArray::shiftVectorLeft(higherFrac, 1);
-    ret.setExponentContainer(retExponent);
-    ret.setFractionContainer(higherFrac);
-    return ret;
+    result.setResult(higher->getSign(), retExponent, higherFrac.data(), size);
+    return;
 }
 
 template<int fraction, int exponent>
-VariableFloat<fraction, exponent> operator - (const VariableFloat<fraction, exponent> &n1, const VariableFloat<fraction, exponent> &n2)
+void VariableFloat<fraction, exponent>::subtract(VariableFloat<fraction, exponent> &result,
+                                                 const VariableFloat<fraction, exponent> &n1,
+                                                 const VariableFloat<fraction, exponent> &n2)
 {
     VariableFloat<fraction, exponent> n2Bf = n2;
     n2Bf.setSign(!n2.getSign());
-    return n1 + n2Bf;
+    add(result, n1, n2Bf);
 }
 
-
 template<int fraction, int exponent>
-VariableFloat<fraction, exponent> operator * (const VariableFloat<fraction, exponent> &n1, const VariableFloat<fraction, exponent> &n2)
+void VariableFloat<fraction, exponent>::multiplySelected(VariableFloat<fraction, exponent> &result,
+                                                         const VariableFloat<fraction, exponent> &n1,
+                                                         const VariableFloat<fraction, exponent> &n2, std::false_type)
 {
-    VariableFloat<fraction, exponent> ret(0.0);
-
-    //Prepare exponent.
-    std::vector<u_char> retExponent = n1.getExponentContainer();
-    ByteArray::subtractBytes(retExponent, n1.getBias());
-
-    std::vector<u_char> secondExponent = n2.getExponentContainer();
-    ByteArray::subtractBytes(secondExponent, n2.getBias());
-
-    ByteArray::addBytes(retExponent, secondExponent);
-
-    //If there is no more bits in fraction container.
-    std::vector<u_char> retFraction = n1.getFractionContainer();
-
-    //If there is no more bits in fraction container.
-    std::vector<u_char> secondFraction = n2.getFractionContainer();
+    typedef VariableFloat<fraction, exponent> Float;
+    const u_int size = Float::fractionLimbs;
+    bool resultSign = n1.getSign() != n2.getSign();
 
-    secondFraction.push_back(0);
-    ByteArray::shiftVectorRight(secondFraction,1);
-    ByteArray::setBit(secondFraction, 0, true);
+    //Check for NaN, infinity or zero.
+    if (n1.isNan() || n2.isNan() || (n1.isInfinity() && n2.isZero()) || (n1.isZero() && n2.isInfinity()))
+    {
+        result.setNan();
+        return;
+    }
+    else if (n1.isInfinity() || n2.isInfinity())
+    {
+        result.setInfinity(resultSign);
+        return;
+    }
+    else if (n1.isZero() || n2.isZero())
+    {
+        result.setZero(resultSign);
+        return;
+    }
 
-    retFraction.push_back(0);
-    ByteArray::shiftVectorRight(retFraction,1);
-    ByteArray::setBit(retFraction, 0, true);
-    int pointPos = retFraction.size()*8 - ByteArray::findHighestOrderOnePosition(retFraction) - 1;
+    //Prepare exponent, product of fractions lies in [1, 4) so highest order bit has a weight of 2.
+    typename Float::ExponentWork retExponent = Float::loadExponent(n1.getExponentContainer());
+    retExponent.add(Float::loadExponent(n2.getExponentContainer()));
+    retExponent.subtract(Float::loadExponent(Float::getBias()));
+    retExponent.add(1);
 
     //Multiply fractions.
-    ByteArray::multiplyBytes(retFraction, secondFraction);
+    std::array<u_int64_t, 2 * size> retFraction;
+    LimbArray::multiplyLimbs(retFraction.data(), n1.getFractionContainer().data(), size,
+                             n2.getFractionContainer().data(), size);
 
-    //Set point at the same position in vector.
-    ByteArray::shiftVectorRight(retFraction, pointPos);
+    result.setResult(resultSign, retExponent, retFraction.data(), 2 * size);
+    return;
+}
 
-    //Save fraction in ret object,
-    //normalisation shift count.
-    int shiftDirection = (signed)secondFraction.size()*8 - (signed)(retFraction.size() * 8 -
-            ByteArray::findHighestOrderOnePosition(retFraction));
+template<int fraction, int exponent>
+void VariableFloat<fraction, exponent>::divideSelected(VariableFloat<fraction, exponent> &result,
+                                                       const VariableFloat<fraction, exponent> &n1,
+                                                       const VariableFloat<fraction, exponent> &n2, std::false_type)
+{
+    typedef VariableFloat<fraction, exponent> Float;
+    const u_int size = Float::fractionLimbs;
+    bool resultSign = n1.getSign() != n2.getSign();
 
-    //Compute exponent shift count and shift it accordingly.
-    if (shiftDirection < 0)
+    //Check if any of the numbers is zero, infinity or NaN.
+    if (n1.isNan() || n2.isNan() || (n1.isZero() && n2.isZero()) || (n1.isInfinity() && n2.isInfinity()))
     {
-        ByteArray::shiftVectorRight(retFraction, -shiftDirection);
-        //Create value only works for char so maximum shift count is 255.
-        ByteArray::addBytes(retExponent, ByteArray::createValue(retExponent.size(), (-shiftDirection) & 0xFF));
-
+        result.setNan();
+        return;
     }
-    else
+    else if (n1.isZero() || n2.isInfinity())
     {
-        ByteArray::shiftVectorLeft(retFraction, shiftDirection);
-        ByteArray::subtractBytes(retExponent, ByteArray::createValue(retExponent.size(), (shiftDirection) & 0xFF));
+        result.setZero(resultSign);
+        return;
+    }
+    else if (n2.isZero() || n1.isInfinity())
+    {
+        result.setInfinity(resultSign);
+        return;
     }
 
-    //Remove extra bytes from ret vector.
-    while (retFraction.size() != secondFraction.size())
-        retFraction.erase(retFraction.begin());
+    //Subtract exponents, quotient of fractions lies in (1/2, 2) so highest order bit has a weight of 1.
+    typename Float::ExponentWork resultExponent = Float::loadExponent(n1.getExponentContainer());
+    resultExponent.subtract(Float::loadExponent(n2.getExponentContainer()));
+    resultExponent.add(Float::loadExponent(Float::getBias()));
 
-    ByteArray::setBit(retFraction, 0, false);
-    ByteArray::shiftVectorLeft(retFraction, 1);
+    //Divide mantissas, one additional limb holds guard bits.
+    std::array<u_int64_t, size + 1> resultMantissa;
+    bool inexact = LimbArray::divideLimbs(resultMantissa.data(), size + 1, n1.getFractionContainer().data(),
+                                          n2.getFractionContainer().data(), size);
+    resultMantissa[0] |= inexact;
 
-    //Remove what has been added before shift.
-    retFraction.erase(retFraction.end()-1);
-    ByteArray::addBytes(retExponent, n1.getBias());
-    ret.setExponentContainer(retExponent);
-    ret.setFractionContainer(retFraction);
-    return ret;
+    result.setResult(resultSign, resultExponent, resultMantissa.data(), size + 1);
+    return;
 }
 
 template<int fraction, int exponent>
-VariableFloat<fraction, exponent> operator / (const VariableFloat<fraction, exponent> &n1, const VariableFloat<fraction, exponent> &n2)
+void VariableFloat<fraction, exponent>::fma(VariableFloat<fraction, exponent> &result,
+                                            const VariableFloat<fraction, exponent> &n1,
+                                            const VariableFloat<fraction, exponent> &n2,
+                                            const VariableFloat<fraction, exponent> &n3)
 {
-    VariableFloat<fraction, exponent> returnNumber(0.0);
-    bool resultSign = n1.getSign() != n2.getSign();
+    //Product is kept exact (2 * fractionLimbs), working container has one additional guard limb.
+    const u_int productSize = 2 * fractionLimbs;
+    const u_int size = productSize + 1;
+    bool productSign = n1.getSign() != n2.getSign();
 
-    //Check if any of the numbers is zero.
-    if (n1.isZero())
+    //Check for NaN, infinity or zero, all of them have a special exponent.
+    if (n1.isSpecial() || n2.isSpecial() || n3.isSpecial())
     {
-        if (n2.isZero())
+        bool productNan = (n1.isInfinity() && n2.isZero()) || (n1.isZero() && n2.isInfinity());
+        if (n1.isNan() || n2.isNan() || n3.isNan() || productNan) result.setNan();
+        else if (n1.isInfinity() || n2.isInfinity())
         {
-            returnNumber.setNan();
-            return returnNumber;
+            if (n3.isInfinity() && n3.getSign() != productSign) result.setNan();
+            else result.setInfinity(productSign);
         }
-        else
+        else if (n3.isInfinity()) result = n3;
+        else if (n1.isZero() || n2.isZero())
         {
-            returnNumber.setZero(resultSign);
-            return returnNumber;
+            if (!n3.isZero()) result = n3;
+            else result.setZero(productSign && n3.getSign());
         }
+        else multiply(result, n1, n2);
+        return;
     }
-    else if (n2.isZero())
+
+    //Exact product placed at the top of working container, normalized so that its highest order bit is set.
+    std::array<u_int64_t, size> productFrac;
+    productFrac[0] = 0;
+    LimbArray::multiplyLimbs(productFrac.data() + 1, n1.getFractionContainer().data(), fractionLimbs,
+                             n2.getFractionContainer().data(), fractionLimbs);
+    ExponentWork productExponent = loadExponent(n1.getExponentContainer());
+    productExponent.add(loadExponent(n2.getExponentContainer()));
+    productExponent.subtract(loadExponent(biasContainer));
+    productExponent.add(1);
+    if (!(productFrac[size - 1] >> 63))
     {
-        returnNumber.setInfinity(resultSign);
-        return returnNumber;
+        LimbArray::shiftLeft(productFrac.data(), size, 1);
+        productExponent.add(-1);
     }
 
-    //Subtract exponents.
-    auto resultExponent = n1.getExponentContainer();
-    auto secondExponent = n2.getExponentContainer();
-    ByteArray::subtractBytes(secondExponent, n1.getBias());
-
-    if (ByteArray::getBit(secondExponent, 0))
+    //Addend placed at the top of working container.
+    std::array<u_int64_t, size> addendFrac;
+    std::fill(addendFrac.begin(), addendFrac.end() - fractionLimbs, 0);
+    std::copy(n3.getFractionContainer().begin(), n3.getFractionContainer().end(), addendFrac.end() - fractionLimbs);
+    ExponentWork addendExponent = loadExponent(n3.getExponentContainer());
+
+    //Operand with greater exponent is higher, exponent difference is non-negative.
+    ExponentWork difference = productExponent;
+    difference.subtract(addendExponent);
+    bool productHigher = !difference.isNegative();
+    if (!productHigher)
     {
-        ByteArray::negateBytes(secondExponent);
-        ByteArray::addBytes(resultExponent, secondExponent);
+        difference = addendExponent;
+        difference.subtract(productExponent);
     }
-    else ByteArray::subtractBytes(resultExponent, secondExponent);
-
-    //Divide mantissas.
-    auto resultMantissa = n1.getFractionContainer();
-    auto secondMantissa = n2.getFractionContainer();
-
-    //Add hidden '1'.
-    resultMantissa.push_back(0);
-    ByteArray::shiftVectorRight(resultMantissa, 1);
-    ByteArray::setBit(resultMantissa, 0, true);
+    bool far = !difference.isBelow(size * 64);
 
-    secondMantissa.push_back(0);
-    ByteArray::shiftVectorRight(secondMantissa, 1);
-    ByteArray::setBit(secondMantissa, 0, true);
-    ByteArray::divideBytes(resultMantissa, secondMantissa, fraction + 5);
-
-    //Find highest order '1' of result mantissa, normalize it and remove leading '1'.
-    int index = ByteArray::findHighestOrderOnePosition(resultMantissa);
-    ByteArray::shiftVectorLeft(resultMantissa, index + 1);
-
-    //Adjust result exponent.
-    auto indexBytes = ByteArray::getBytesFromInt(index, resultExponent.size());
-    bool overflow = ByteArray::subtractBytes(resultExponent, indexBytes);
+    //With exponent difference of at least 2 at most one bit cancels, so only the highest order limbs
+    //of the working container take part in rounding. Lower order limbs of the product are replaced by
+    //a sticky bit, the addend must stay entirely above the lowest working limb (one operand loses bits).
+    u_int width = size;
+    if (far || difference.getLow() >= 2)
+    {
+        if (!productHigher) width = fractionLimbs + 2;
+        else if (!far) width = std::min(size, fractionLimbs + 1 + (u_int) (difference.getLow() + 63) / 64);
+    }
+    u_int64_t *productWindow = productFrac.data() + size - width;
+    u_int64_t *addendWindow = addendFrac.data() + size - width;
+    productWindow[0] |= !LimbArray::checkIfZero(productFrac.data(), size - width);
+
+    u_int64_t *higherFrac = productHigher ? productWindow : addendWindow;
+    u_int64_t *lowerFrac = productHigher ? addendWindow : productWindow;
+    ExponentWork resultExponent = productHigher ? productExponent : addendExponent;
+    bool resultSign = productHigher ? productSign : n3.getSign();
+
+    //Align lower operand with a single shift, bits shifted out are kept as a sticky bit.
+    //More than one bit of cancellation is only possible for differences of 0 or 1, which lose no bits.
+    bool sticky;
+    if (far)
+    {
+        std::fill(lowerFrac, lowerFrac + width, 0);
+        sticky = true;
+    }
+    else sticky = LimbArray::shiftRightSticky(lowerFrac, width, (u_int) difference.getLow());
+    lowerFrac[0] |= sticky;
 
-    //Check for over or underflow.
-    if (overflow)
+    if (productSign == n3.getSign())
     {
-        returnNumber.setInfinity(resultSign);
-        return returnNumber;
+        if (LimbArray::addLimbs(higherFrac, lowerFrac, width))
+        {
+            sticky = higherFrac[0] & 1;
+            LimbArray::shiftRight(higherFrac, width, 1);
+            higherFrac[0] |= sticky;
+            higherFrac[width - 1] |= (u_int64_t) 1 << 63;
+            resultExponent.add(1);
+        }
     }
-    else if (ByteArray::compare(resultExponent, n1.getMinExponent()) == -1)
+    else
     {
-        returnNumber.setSign(resultSign);
-        return returnNumber;
+        //With equal exponents lower operand may be greater, then the difference changes sign.
+        if (LimbArray::subtractLimbs(higherFrac, lowerFrac, width))
+        {
+            LimbArray::negateLimbs(higherFrac, width);
+            resultSign = !resultSign;
+        }
+        if (LimbArray::checkIfZero(higherFrac, width))
+        {
+            result.setZero(false);
+            return;
+        }
     }
 
-    //Save the result.
-    returnNumber.setSign(resultSign);
-    returnNumber.setExponentContainer(resultExponent);
-    returnNumber.setFractionContainer(resultMantissa);
-    return returnNumber;
+    result.setResult(resultSign, resultExponent, higherFrac, width);
 }
 
 template<int fraction, int exponent>
-VariableFloat<fraction, exponent> VariableFloat<fraction, exponent>::sqrt(const VariableFloat<fraction, exponent> &number)
+VariableFloat<fraction, exponent> VariableFloat<fraction, exponent>::fma(const VariableFloat<fraction, exponent> &n1,
+                                                                         const VariableFloat<fraction, exponent> &n2,
+                                                                         const VariableFloat<fraction, exponent> &n3)
+{
+    VariableFloat<fraction, exponent> result;
+    fma(result, n1, n2, n3);
+    return result;
+}
+
+template<int fraction, int exponent>
+void VariableFloat<fraction, exponent>::sqrtSelected(VariableFloat<fraction, exponent> &result,
+                                                     const VariableFloat<fraction, exponent> &number, std::false_type)
 {
-    VariableFloat<fraction, exponent> returnNumber(0.0f);
+    const u_int size = fractionLimbs + 1;
 
     //Check for zero, infinity or NaN.
-    if (number.isZero()) return returnNumber;
-    else if (number.isPositiveInfinity())
+    if (number.isZero())
     {
-        returnNumber.setInfinity(false);
-        return returnNumber;
+        result.setZero(false);
+        return;
     }
-    else if (number.isNegativeInfinity() || number.getSign())
+    else if (number.isNan() || number.getSign())
     {
-        returnNumber.setNan();
-        return returnNumber;
+        result.setNan();
+        return;
     }
-    else if (number.isNan())
+    else if (number.isInfinity())
     {
-        returnNumber.setNan();
-        return returnNumber;
+        result.setInfinity(false);
+        return;
     }
 
-    //Copy required containers.
-    auto resultExponent = number.getExponentContainer();
-    auto resultMantissa = number.getFractionContainer();
+    //Compute unbiased exponent, if it is not even subtract 1 (and double the fraction).
+    ExponentWork resultExponent = loadExponent(number.getExponentContainer());
+    resultExponent.subtract(loadExponent(biasContainer));
+    bool exponentOdd = resultExponent.getLow() & 1;
+    if (exponentOdd) resultExponent.add(-1);
 
-    //Adjust final exponent.
-    bool exponentNegative = ByteArray::subtractBytes(resultExponent, number.getBias());
-    bool exponentModified = false;
-    //If exponent is not even subtract 1.
-    int bitCount = resultExponent.size() * 8;
-    if (exponentNegative)
-    {
-        //Negative and uneven.
-        if (ByteArray::getBit(resultExponent, bitCount - 1))
-        {
-            ByteArray::negateBytes(resultExponent);
-            ByteArray::addBytes(resultExponent, ByteArray::getBytesFromInt(1, resultExponent.size()));
-            ByteArray::shiftVectorRight(resultExponent, 1);
-            ByteArray::negateBytes(resultExponent);
-            exponentModified = true;
-        }
-        //Negative and even.
-        else
-        {
-            ByteArray::negateBytes(resultExponent);
-            ByteArray::shiftVectorRight(resultExponent, 1);
-            ByteArray::negateBytes(resultExponent);
-        }
-    }
-    else
-    {
-        //Positive and uneven.
-        if (ByteArray::getBit(resultExponent, bitCount - 1))
-        {
-            ByteArray::subtractBytes(resultExponent, ByteArray::getBytesFromInt(1, resultExponent.size()));
-            exponentModified = true;
-        }
-        ByteArray::shiftVectorRight(resultExponent, 1);
-    }
-    ByteArray::addBytes(resultExponent, number.getBias());
+    //Halve the exponent (arithmetic shift) and add bias.
+    resultExponent.halve();
+    resultExponent.add(loadExponent(biasContainer));
 
-    //Add hidden '1'.
-    resultMantissa.push_back(0);
-    ByteArray::shiftVectorRight(resultMantissa, 1);
-    ByteArray::setBit(resultMantissa, 0, true);
+    //Radicand is the fraction placed at the top of a double size container, so that root has 'size' limbs.
+    std::array<u_int64_t, 2 * size> radicand{};
+    std::copy(number.getFractionContainer().begin(), number.getFractionContainer().end(),
+              radicand.begin() + 2 * size - fractionLimbs);
+    LimbArray::shiftRight(radicand.data(), 2 * size, exponentOdd ? 0 : 1);
 
     //Compute square root of resultFraction.
-    int precision = fraction + 5;
-    if (!exponentModified)
-    {
-        precision++;
-        ByteArray::shiftVectorRight(resultMantissa, 1);
-    }
-    ByteArray::squareRootBytes(resultMantissa, precision);
+    std::array<u_int64_t, size> resultMantissa;
+    bool inexact = LimbArray::squareRootLimbs(resultMantissa.data(), radicand.data(), 2 * size);
+    resultMantissa[0] |= inexact;
 
-    //Normalize mantissa and remove leading '1'.
-    int index = ByteArray::findHighestOrderOnePosition(resultMantissa);
-    ByteArray::shiftVectorLeft(resultMantissa, index + 1);
+    result.setResult(false, resultExponent, resultMantissa.data(), size);
+    return;
+}
 
-    //Adjust result exponent.
-    auto indexBytes = ByteArray::getBytesFromInt(index, resultExponent.size());
-    bool overflow = ByteArray::subtractBytes(resultExponent, indexBytes);
+template<int fraction, int exponent>
+void VariableFloat<fraction, exponent>::addSelected(VariableFloat<fraction, exponent> &result,
+                                                    const VariableFloat<fraction, exponent> &n1,
+                                                    const VariableFloat<fraction, exponent> &n2, std::true_type)
+{
+    if (n1.isSpecial() || n2.isSpecial()) addSelected(result, n1, n2, std::false_type());
+    else Backend::add(result, n1, n2);
+}
 
-    //Check for over or underflow.
-    if (overflow)
-    {
-        returnNumber.setInfinity(false);
-        return returnNumber;
-    }
-    else if (ByteArray::compare(resultExponent, number.getMinExponent()) == -1)
-    {
-        return returnNumber;
-    }
+template<int fraction, int exponent>
+void VariableFloat<fraction, exponent>::multiplySelected(VariableFloat<fraction, exponent> &result,
+                                                         const VariableFloat<fraction, exponent> &n1,
+                                                         const VariableFloat<fraction, exponent> &n2, std::true_type)
+{
+    if (n1.isSpecial() || n2.isSpecial()) multiplySelected(result, n1, n2, std::false_type());
+    else Backend::multiply(result, n1, n2);
+}
+
+template<int fraction, int exponent>
+void VariableFloat<fraction, exponent>::divideSelected(VariableFloat<fraction, exponent> &result,
+                                                       const VariableFloat<fraction, exponent> &n1,
+                                                       const VariableFloat<fraction, exponent> &n2, std::true_type)
+{
+    if (n1.isSpecial() || n2.isSpecial()) divideSelected(result, n1, n2, std::false_type());
+    else Backend::divide(result, n1, n2);
+}
+
+template<int fraction, int exponent>
+void VariableFloat<fraction, exponent>::sqrtSelected(VariableFloat<fraction, exponent> &result,
+                                                     const VariableFloat<fraction, exponent> &number, std::true_type)
+{
+    if (number.isSpecial() || number.getSign()) sqrtSelected(result, number, std::false_type());
+    else Backend::sqrt(result, number);
+}
 
-    //Save the result.
-    returnNumber.setExponentContainer(resultExponent);
-    returnNumber.setFractionContainer(resultMantissa);
-    return returnNumber;
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> VariableFloat<fraction, exponent>::sqrt(const VariableFloat<fraction, exponent> &number)
+{
+    VariableFloat<fraction, exponent> result;
+    sqrt(result, number);
+    return result;
 }
 
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> operator + (const VariableFloat<fraction, exponent> &n1, const VariableFloat<fraction, exponent> &n2)
+{
+    VariableFloat<fraction, exponent> result;
+    VariableFloat<fraction, exponent>::add(result, n1, n2);
+    return result;
+}
+
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> operator - (const VariableFloat<fraction, exponent> &n1, const VariableFloat<fraction, exponent> &n2)
+{
+    VariableFloat<fraction, exponent> result;
+    VariableFloat<fraction, exponent>::subtract(result, n1, n2);
+    return result;
+}
+
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> operator * (const VariableFloat<fraction, exponent> &n1, const VariableFloat<fraction, exponent> &n2)
+{
+    VariableFloat<fraction, exponent> result;
+    VariableFloat<fraction, exponent>::multiply(result, n1, n2);
+    return result;
+}
+
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> operator / (const VariableFloat<fraction, exponent> &n1, const VariableFloat<fraction, exponent> &n2)
+{
+    VariableFloat<fraction, exponent> result;
+    VariableFloat<fraction, exponent>::divide(result, n1, n2);
+    return result;
+}
+
+/// Computes n1 * n2 + n3 with a single rounding.
+/// \param n1 - first multiplication operand.
+/// \param n2 - second multiplication operand.
+/// \param n3 - addition operand.
+/// \return Fused multiply-add result.
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> fma(const VariableFloat<fraction, exponent> &n1, const VariableFloat<fraction, exponent> &n2,
+                                      const VariableFloat<fraction, exponent> &n3)
+{
+    return VariableFloat<fraction, exponent>::fma(n1, n2, n3);
+}
 
 template<int fraction, int exponent>
 std::ostream& operator<<(std::ostream &str, const VariableFloat<fraction, exponent> &obj)
@@ -689,40 +912,32 @@ void VariableFloat<fraction,exponent>::printContainers(std::ostream &str) const
     else if (isNan()) str << "NaN";
     else
     {
-        std::vector<u_char> copy(exponentContainer);
-
-        if(!ByteArray::checkIfZero(exponentContainer))
-            ByteArray::subtractBytes(copy, biasContainer);
+        ExponentWork copy = loadExponent(exponentContainer);
+        if (!isZero()) copy.subtract(loadExponent(biasContainer));
 
         str << "0x";
 
-        for (unsigned char i : copy)
+        for (unsigned char i : ByteArray::limbsToBytes(copy.toLimbs().data(), exponentLimbs + 1, exponentSize))
         {
             str << std::hex << std::setfill('0') << std::setw(2) << (unsigned) i;
         }
         str << " ";
 
+        //Remove hidden '1' and align fraction bits to the highest order bit of fraction bytes.
+        std::array<u_int64_t, fractionLimbs + 1> fractionCopy{};
+        std::copy(fractionContainer.begin(), fractionContainer.end(), fractionCopy.begin());
+        fractionCopy[fractionLimbs - 1] &= ~((u_int64_t) 1 << 63);
+        LimbArray::shiftRight(fractionCopy.data(), fractionLimbs + 1, fractionLimbs * 64 - fraction - 1);
+        LimbArray::shiftLeft(fractionCopy.data(), fractionLimbs + 1, fractionSize * 8 - fraction);
+
         str << "0x";
-        for(unsigned char i : fractionContainer)
+        for (unsigned char i : ByteArray::limbsToBytes(fractionCopy.data(), fractionLimbs + 1, fractionSize))
         {
             str << std::hex << std::setfill('0') << std::setw(2) << (unsigned) i;
         }
     }
 }
 
-template<int fraction, int exponent>
-std::vector<u_char> VariableFloat<fraction, exponent>::createBiasContainerForExponent(int customExponent)
-{
-    std::vector<u_char> customBias;
-    int customExponentSize = (customExponent / 8) + 1;
-    customBias.reserve(customExponentSize);
-    for (int i = 0; i < customExponentSize; ++i) customBias.push_back(255);
-
-    int shiftCount = customExponentSize * 8 - (customExponent - 1);
-    ByteArray::shiftVectorRight(customBias, shiftCount);
-    return customBias;
-}
-
 template<int fraction, int exponent>
 std::vector<u_char> VariableFloat<fraction, exponent>::hexStringToBytes(const std::string &input)
 {
@@ -737,169 +952,143 @@ std::vector<u_char> VariableFloat<fraction, exponent>::hexStringToBytes(const st
 }
 
 template<int fraction, int exponent>
-int VariableFloat<fraction, exponent>::checkForOverflow(std::vector<u_char> &currentExponent)
+int VariableFloat<fraction, exponent>::checkForOverflow(const ExponentWork &currentExponent)
 {
-    std::vector<u_char> temp = std::vector<u_char>(currentExponent);
-    if (ByteArray::compare(temp, maxExponent) == 1) return 1;
-    else if (ByteArray::compare(temp, minExponent) == -1) return -1;
+    if (currentExponent.compare(maxExponent) == 1) return 1;
+    else if (currentExponent.compare(minExponent) == -1) return -1;
     return 0;
 }
 
 template<int fraction, int exponent>
-std::vector<u_char> &VariableFloat<fraction, exponent>::roundFraction(std::vector<u_char> &currentFraction)
+void VariableFloat<fraction, exponent>::setFromBinary(bool numberSign, u_int64_t numberExponent,
+                                                      u_int64_t numberFraction, u_int exponentBits,
+                                                      u_int fractionBits)
 {
-    int rBitPosition = fraction;
-    int arraySize = currentFraction.size() * 8;
-    bool rBit = ByteArray::getBit(currentFraction, rBitPosition);
-    bool sBit = false;
+    u_int64_t maxNumberExponent = (1ull << exponentBits) - 1;
+    long long numberBias = (1ll << (exponentBits - 1)) - 1;
 
-    //Check whether there are any '1's later in the fraction.
-    for (int i = rBitPosition + 1; i < arraySize; ++i)
+    if (numberExponent == maxNumberExponent)
     {
-        if (ByteArray::getBit(currentFraction, i))
-        {
-            sBit = true;
-            break;
-        }
+        if (numberFraction != 0) setNan();
+        else setInfinity(numberSign);
+        return;
+    }
+    else if (numberExponent == 0 && numberFraction == 0)
+    {
+        setZero(numberSign);
+        return;
     }
 
-    //R = 1 and S = 1.
-    if (rBit && sBit)
+    //Denormalized numbers have no hidden '1' and the same exponent as the lowest normalized ones.
+    long long unbiasedExponent = numberExponent == 0 ? 1 - numberBias : (long long) numberExponent - numberBias;
+    if (numberExponent != 0) numberFraction |= 1ull << fractionBits;
+
+    //Place the significand in the highest order limb, highest order bit has a weight of 2^fractionBits.
+    std::array<u_int64_t, fractionLimbs + 1> resultFraction{};
+    resultFraction[fractionLimbs] = numberFraction << (63 - fractionBits);
+    ExponentWork resultExponent = loadExponent(biasContainer);
+    resultExponent.add(unbiasedExponent);
+    setResult(numberSign, resultExponent, resultFraction.data(), fractionLimbs + 1);
+}
+
+template<int fraction, int exponent>
+typename VariableFloat<fraction, exponent>::ExponentWork
+VariableFloat<fraction, exponent>::loadExponent(const ExponentLimbs &source)
+{
+    return ExponentWork(source);
+}
+
+template<int fraction, int exponent>
+void VariableFloat<fraction, exponent>::adjustExponent(ExponentWork &currentExponent, long long value)
+{
+    currentExponent.add(value);
+}
+
+template<int fraction, int exponent>
+void VariableFloat<fraction, exponent>::setResult(bool resultSign, ExponentWork &resultExponent,
+                                                  u_int64_t *significand, u_int size)
+{
+    //Normalize, so that highest order bit is the hidden '1'.
+    u_int zeros = LimbArray::countLeadingZeros(significand, size);
+    if (zeros == size * 64)
     {
-        if (!ByteArray::getBit(currentFraction, fraction - 1))
-        {
-            ByteArray::setBit(currentFraction, fraction - 1, true);
-            for (int i = fraction; i < arraySize; i++)
-                ByteArray::setBit(currentFraction, i, false);
-        }
-        else
-        {
-            for (int i = fraction - 2; i >= 0; --i)
-            {
-                if (!ByteArray::getBit(currentFraction, i))
-                {
-                    ByteArray::setBit(currentFraction, i, true);
-                    for (int j = i + 1; j < arraySize; j++)
-                        ByteArray::setBit(currentFraction, j, false);
-                    break;
-                }
-            }
-        }
+        setZero(resultSign);
+        return;
     }
-    //R = 1 and S = 0.
-    else if (rBit && !sBit)
+    LimbArray::shiftLeft(significand, size, zeros);
+    resultExponent.add(-(long long) zeros);
+
+    //Round the fraction, carry out of the container means the fraction became 1.0 * 2.
+    if (LimbArray::roundNearestEven(significand, size, fraction + 1))
     {
-        if (ByteArray::getBit(currentFraction, fraction - 1))
-        {
-            for (int i = fraction - 2; i >= 0; --i)
-            {
-                if (!ByteArray::getBit(currentFraction, i))
-                {
-                    ByteArray::setBit(currentFraction, i, true);
-                    for (int j = i + 1; j < arraySize; j++)
-                        ByteArray::setBit(currentFraction, j, false);
-                    break;
-                }
-            }
-        }
-        else
-        {
-            for (int i = fraction; i < arraySize; ++i)
-                ByteArray::setBit(currentFraction, i, false);
-        }
+        significand[size - 1] = (u_int64_t) 1 << 63;
+        resultExponent.add(1);
     }
-    else
+
+    switch (checkForOverflow(resultExponent))
     {
-        for (int i = fraction; i < arraySize; ++i)
-            ByteArray::setBit(currentFraction, i, false);
+        case 1:
+            setInfinity(resultSign);
+            break;
+        case -1:
+            setZero(resultSign);
+            break;
+        default:
+            sign = resultSign;
+            resultExponent.store(exponentContainer);
+            std::copy(significand + size - fractionLimbs, significand + size, fractionContainer.begin());
     }
-    return currentFraction;
 }
 
 template<int fraction, int exponent>
 bool VariableFloat<fraction, exponent>::isNan() const
 {
-    for (unsigned int i = 0; i < exponentContainer.size(); ++i)
-    {
-        if (exponentContainer[i] != 255)
-            return false;
-    }
+    return LimbArray::compare(exponentContainer.data(), infinityExponent.data(), exponentLimbs) == 0 &&
+           !LimbArray::checkIfZero(fractionContainer.data(), fractionLimbs);
+}
 
-    bool fractionSet = false;
-    for (unsigned int i = 0; i < exponentContainer.size(); ++i)
-    {
-        if (exponentContainer[i] != 0)
-        {
-            fractionSet = true;
-            break;
-        }
-    }
-    return fractionSet;
+template<int fraction, int exponent>
+bool VariableFloat<fraction, exponent>::isSpecial() const
+{
+    return isZero() || LimbArray::compare(exponentContainer.data(), infinityExponent.data(), exponentLimbs) == 0;
 }
 
 template<int fraction, int exponent>
 bool VariableFloat<fraction, exponent>::isZero() const
 {
-    for (unsigned int i = 0; i < exponentContainer.size(); ++i)
-    {
-        if (exponentContainer[i] != 0)
-            return false;
-    }
-
-    for (unsigned int i = 0; i < fractionContainer.size(); ++i)
-    {
-        if (fractionContainer[i] != 0)
-            return false;
-    }
-    return true;
+    return LimbArray::checkIfZero(exponentContainer.data(), exponentLimbs);
 }
 
 template<int fraction, int exponent>
 bool VariableFloat<fraction, exponent>::isInfinity() const
 {
-    for (unsigned int i = 0; i < exponentContainer.size(); ++i)
-    {
-        if (exponentContainer[i] != 255)
-            return false;
-    }
-
-    for (unsigned int i = 0; i < exponentContainer.size(); ++i)
-    {
-        if (exponentContainer[i] != 0)
-            return false;
-    }
-    return true;
+    return LimbArray::compare(exponentContainer.data(), infinityExponent.data(), exponentLimbs) == 0 &&
+           LimbArray::checkIfZero(fractionContainer.data(), fractionLimbs);
 }
 
 template<int fraction, int exponent>
 bool VariableFloat<fraction, exponent>::isNegativeInfinity() const
 {
-    return !sign && isInfinity();
+    return sign && isInfinity();
 }
 
 template<int fraction, int exponent>
 bool VariableFloat<fraction, exponent>::isPositiveInfinity() const
 {
-    return sign && isInfinity();
+    return !sign && isInfinity();
 }
 
 template<int fraction, int exponent>
 std::string VariableFloat<fraction, exponent>::toBinary() const
 {
-    std::vector<u_char> exp = getExponentContainer();
-    ByteArray::subtractBytes(exp, biasContainer);
+    ExponentWork exp = loadExponent(exponentContainer);
+    exp.subtract(loadExponent(biasContainer));
 
-    std::vector<u_char> frac = getFractionContainer();
-    frac.push_back(0);
-    ByteArray::shiftVectorRight(frac,1);
-    ByteArray::setBit(frac, 0, true);
+    //Point is only placed for exponents that fit in the string.
+    u_int pointPos = (u_int) -1;
+    if (exp.isBelow(fractionLimbs * 64)) pointPos = (u_int) exp.getLow() + 1;
 
-    int pointPos = 1;
-    while (!ByteArray::checkIfZero(exp))
-    {
-        pointPos ++;
-        ByteArray::subtractBytes(exp, ByteArray::createOne(exp.size()));
-    }
+    std::vector<u_char> frac = ByteArray::limbsToBytes(fractionContainer.data(), fractionLimbs, fractionLimbs * 8);
     return (!getSign() ? "+ ":"- ") + ByteArray::toBinaryString(frac, pointPos);
 }
 
@@ -907,21 +1096,76 @@ template<int fraction, int exponent>
 void VariableFloat<fraction, exponent>::setZero(bool setSign)
 {
     sign = setSign;
-    for (int i = 0; i < exponentSize; ++i) exponentContainer[i] = 0;
-    for (int i = 0; i < fractionSize; ++i) fractionContainer[i] = 0;
+    exponentContainer.fill(0);
+    fractionContainer.fill(0);
 }
 
 template<int fraction, int exponent>
 void VariableFloat<fraction, exponent>::setInfinity(bool setSign)
 {
     sign = setSign;
-    for (unsigned int i = 0; i < exponentSize; ++i) exponentContainer[i] = 255;
-    for (unsigned int i = 0; i < fractionSize; ++i) fractionContainer[i] = 0;
+    exponentContainer = infinityExponent;
+    fractionContainer.fill(0);
 }
 
 template<int fraction, int exponent>
 void VariableFloat<fraction, exponent>::setNan()
 {
-    for (int i = 0; i < exponentSize; ++i) exponentContainer[i] = 255;
-    fractionContainer[0] = 255;
-}
\ No newline at end of file
+    sign = false;
+    exponentContainer = infinityExponent;
+    fractionContainer.fill(0);
+    fractionContainer[fractionLimbs - 1] = (u_int64_t) 3 << 62;
+}
+
+
+/// Output parameter arithmetic API. Results are written into a caller owned destination,
+/// which may be the same object as any operand.
+namespace vf
+{
+    /// Stores a + b in 'out'.
+    template<int fraction, int exponent>
+    inline void add(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> &a,
+                    const VariableFloat<fraction, exponent> &b)
+    {
+        VariableFloat<fraction, exponent>::add(out, a, b);
+    }
+
+    /// Stores a - b in 'out'.
+    template<int fraction, int exponent>
+    inline void sub(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> &a,
+                    const VariableFloat<fraction, exponent> &b)
+    {
+        VariableFloat<fraction, exponent>::subtract(out, a, b);
+    }
+
+    /// Stores a * b in 'out'.
+    template<int fraction, int exponent>
+    inline void mul(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> &a,
+                    const VariableFloat<fraction, exponent> &b)
+    {
+        VariableFloat<fraction, exponent>::multiply(out, a, b);
+    }
+
+    /// Stores a / b in 'out'.
+    template<int fraction, int exponent>
+    inline void div(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> &a,
+                    const VariableFloat<fraction, exponent> &b)
+    {
+        VariableFloat<fraction, exponent>::divide(out, a, b);
+    }
+
+    /// Stores square root of a in 'out'.
+    template<int fraction, int exponent>
+    inline void sqrt(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> &a)
+    {
+        VariableFloat<fraction, exponent>::sqrt(out, a);
+    }
+
+    /// Stores a * b + c (rounded once) in 'out'.
+    template<int fraction, int exponent>
+    inline void fma(VariableFloat<fraction, exponent> &out, const VariableFloat<fraction, exponent> &a,
+                    const VariableFloat<fraction, exponent> &b, const VariableFloat<fraction, exponent> &c)
+    {
+        VariableFloat<fraction, exponent>::fma(out, a, b, c);
+    }
+}
@@ -0,0 +1,682 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#include "LimbPlanes.h"
+#include "ScratchArena.h"
+#include "VariableFloat.h"
+
+template<int fraction, int exponent>
+/// Structure of arrays container for many numbers of the same representation.
+/// Signs, exponent limbs and fraction limbs are kept in separate contiguous 64-byte aligned planes.
+/// Limb planes are limb-major: limb 'j' of element 'i' is at [j * stride + i], so that the same limb
+/// of neighbouring numbers is adjacent in memory.
+/// \tparam fraction - fraction bit count.
+/// \tparam exponent - exponent bit count.
+class VariableFloatArray
+{
+public:
+    typedef VariableFloat<fraction, exponent> Float;
+
+    /// Alignment of every plane in bytes.
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    /// Proxy referencing a single element, converts to and from VariableFloat.
+    class Reference
+    {
+    public:
+        /// Loads the referenced element.
+        operator Float() const { return array.get(index); }
+
+        /// Stores a number in the referenced element.
+        /// \param value - number to be stored.
+        /// \return Reference to this proxy.
+        Reference &operator=(const Float &value)
+        {
+            array.set(index, value);
+            return *this;
+        }
+
+        /// Copies another element into the referenced element.
+        /// \param other - proxy of the element to be copied.
+        /// \return Reference to this proxy.
+        Reference &operator=(const Reference &other) { return *this = (Float) other; }
+
+    private:
+        friend class VariableFloatArray<fraction, exponent>;
+
+        Reference(VariableFloatArray<fraction, exponent> &owner, std::size_t position)
+            : array(owner), index(position) {}
+
+        VariableFloatArray<fraction, exponent> &array;
+        std::size_t index;
+    };
+
+    /// Creates an array of 'count' positive zeros.
+    /// \param count - element count.
+    explicit VariableFloatArray(std::size_t count = 0);
+
+    /// VariableFloatArray copy constructor.
+    VariableFloatArray(const VariableFloatArray<fraction, exponent> &other);
+
+    /// VariableFloatArray move constructor.
+    VariableFloatArray(VariableFloatArray<fraction, exponent> &&other) noexcept = default;
+
+    /// VariableFloatArray copy assignment operator.
+    VariableFloatArray<fraction, exponent> &operator=(const VariableFloatArray<fraction, exponent> &other);
+
+    /// VariableFloatArray move assignment operator.
+    VariableFloatArray<fraction, exponent> &
+    operator=(VariableFloatArray<fraction, exponent> &&other) noexcept = default;
+
+    /// Returns element count.
+    /// \return Element count.
+    std::size_t size() const { return count; }
+
+    /// Returns distance between the same limb of neighbouring planes (element capacity).
+    /// \return Plane stride in elements.
+    std::size_t getStride() const { return stride; }
+
+    /// Returns a proxy of an element.
+    /// \param index - element index.
+    /// \return Element proxy.
+    Reference operator[](std::size_t index) { return Reference(*this, index); }
+
+    /// Returns a copy of an element.
+    /// \param index - element index.
+    /// \return Element value.
+    Float operator[](std::size_t index) const { return get(index); }
+
+    /// Returns a copy of an element.
+    /// \param index - element index.
+    /// \return Element value.
+    Float get(std::size_t index) const;
+
+    /// Loads an element into an existing number.
+    /// \param index - element index.
+    /// \param value - destination number.
+    void get(std::size_t index, Float &value) const;
+
+    /// Stores a number in an element.
+    /// \param index - element index.
+    /// \param value - number to be stored.
+    void set(std::size_t index, const Float &value);
+
+    /// Returns sign plane (1 - negative, 0 - positive).
+    /// \return Pointer to the first sign.
+    u_char *signs() { return signPlane.get(); }
+
+    /// Returns sign plane (1 - negative, 0 - positive).
+    /// \return Pointer to the first sign.
+    const u_char *signs() const { return signPlane.get(); }
+
+    /// Returns a plane holding exponent limb 'limb' of every element.
+    /// \param limb - limb index (0 - lowest order).
+    /// \return Pointer to the limb of the first element.
+    u_int64_t *exponents(u_int limb) { return exponentPlane.get() + limb * stride; }
+
+    /// Returns a plane holding exponent limb 'limb' of every element.
+    /// \param limb - limb index (0 - lowest order).
+    /// \return Pointer to the limb of the first element.
+    const u_int64_t *exponents(u_int limb) const { return exponentPlane.get() + limb * stride; }
+
+    /// Returns a plane holding fraction limb 'limb' of every element.
+    /// \param limb - limb index (0 - lowest order).
+    /// \return Pointer to the limb of the first element.
+    u_int64_t *fractions(u_int limb) { return fractionPlane.get() + limb * stride; }
+
+    /// Returns a plane holding fraction limb 'limb' of every element.
+    /// \param limb - limb index (0 - lowest order).
+    /// \return Pointer to the limb of the first element.
+    const u_int64_t *fractions(u_int limb) const { return fractionPlane.get() + limb * stride; }
+
+    /// Checks if an element is zero, infinity or NaN.
+    /// \param index - element index.
+    /// \return True if the element's exponent is zero or all ones.
+    bool isSpecial(std::size_t index) const;
+
+    /// Adds arrays elementwise (result[i] = n1[i] + n2[i]) with lane parallel LimbPlanes kernels.
+    /// Results are the same as of VariableFloat::add applied to every element.
+    /// \param result - destination array (may be the same as any operand).
+    /// \param n1 - first operand array.
+    /// \param n2 - second operand array.
+    static void add(VariableFloatArray<fraction, exponent> &result, const VariableFloatArray<fraction, exponent> &n1,
+                    const VariableFloatArray<fraction, exponent> &n2);
+
+    /// Subtracts arrays elementwise (result[i] = n1[i] - n2[i]) with lane parallel LimbPlanes kernels.
+    /// Results are the same as of VariableFloat::subtract applied to every element.
+    /// \param result - destination array (may be the same as any operand).
+    /// \param n1 - first operand array.
+    /// \param n2 - second operand array.
+    static void subtract(VariableFloatArray<fraction, exponent> &result,
+                         const VariableFloatArray<fraction, exponent> &n1,
+                         const VariableFloatArray<fraction, exponent> &n2);
+
+    /// Compares magnitudes of the elements (exponents first, then fractions).
+    /// \param result - per element result: 1 - |n1[i]| is bigger, -1 - |n2[i]| is bigger, 0 - equal.
+    /// \param n1 - first operand array.
+    /// \param n2 - second operand array.
+    static void compareMagnitudes(signed char *result, const VariableFloatArray<fraction, exponent> &n1,
+                                  const VariableFloatArray<fraction, exponent> &n2);
+
+private:
+    /// Element count processed at once by batch operations, scratch planes of a block stay in L1 cache.
+    static constexpr std::size_t BLOCK = 64;
+
+    /// Stride of scratch planes of a block, padded by one cache line for the same reason as 'planeStride'.
+    static constexpr std::size_t SCRATCH_STRIDE = BLOCK + 8;
+
+    /// Compares magnitudes of elements 'base' .. 'base' + 'count' - 1.
+    /// \param result - per element result for the block.
+    /// \param n1 - first operand array.
+    /// \param n2 - second operand array.
+    /// \param base - first element of the block.
+    /// \param count - element count of the block (at most BLOCK).
+    static void compareBlock(signed char *result, const VariableFloatArray<fraction, exponent> &n1,
+                             const VariableFloatArray<fraction, exponent> &n2, std::size_t base, std::size_t count);
+
+    /// Adds arrays elementwise, the sign of the second operand can be reversed.
+    /// \param result - destination array.
+    /// \param n1 - first operand array.
+    /// \param n2 - second operand array.
+    /// \param negateSecond - if true then n1[i] - n2[i] is computed.
+    static void addSigned(VariableFloatArray<fraction, exponent> &result,
+                          const VariableFloatArray<fraction, exponent> &n1,
+                          const VariableFloatArray<fraction, exponent> &n2, bool negateSecond);
+
+    /// Deleter for memory allocated with 'allocatePlane', the block returned by the global allocator is stored
+    /// just below the plane.
+    struct PlaneDeleter
+    {
+        void operator()(void *pointer) const
+        {
+            if (pointer != nullptr) ::operator delete(static_cast<void **>(pointer)[-1]);
+        }
+    };
+
+    /// Returns plane stride for an element count: a whole, odd number of aligned blocks.
+    /// Odd stride makes consecutive limbs of one element fall into different cache sets.
+    /// \param count - element count.
+    /// \return Plane stride in elements.
+    static std::size_t planeStride(std::size_t count)
+    {
+        const std::size_t perBlock = ALIGNMENT / sizeof(u_int64_t);
+        std::size_t blocks = (count + perBlock - 1) / perBlock;
+        return (blocks | 1) * perBlock;
+    }
+
+    /// Allocates a zeroed, aligned plane through the global allocator (so that replacements of operator new
+    /// see plane allocations too).
+    /// \param bytes - plane size in bytes.
+    /// \return Pointer to the plane.
+    template<typename T>
+    static std::unique_ptr<T[], PlaneDeleter> allocatePlane(std::size_t bytes);
+
+    std::size_t count;
+
+    /// Element capacity of a plane (count rounded up to a whole number of aligned blocks).
+    std::size_t stride;
+
+    std::unique_ptr<u_char[], PlaneDeleter> signPlane;
+    std::unique_ptr<u_int64_t[], PlaneDeleter> exponentPlane;
+    std::unique_ptr<u_int64_t[], PlaneDeleter> fractionPlane;
+};
+
+template<int fraction, int exponent>
+constexpr std::size_t VariableFloatArray<fraction, exponent>::ALIGNMENT;
+
+template<int fraction, int exponent>
+constexpr std::size_t VariableFloatArray<fraction, exponent>::BLOCK;
+
+template<int fraction, int exponent>
+constexpr std::size_t VariableFloatArray<fraction, exponent>::SCRATCH_STRIDE;
+
+template<int fraction, int exponent>
+template<typename T>
+std::unique_ptr<T[], typename VariableFloatArray<fraction, exponent>::PlaneDeleter>
+VariableFloatArray<fraction, exponent>::allocatePlane(std::size_t bytes)
+{
+    //Global allocator memory is aligned to at least a pointer, so the aligned plane leaves room for it below.
+    static_assert(ALIGNMENT >= 2 * sizeof(void *), "Plane alignment must leave room for the block pointer.");
+    void *block = ::operator new(bytes + ALIGNMENT);
+    void *pointer = reinterpret_cast<void *>((reinterpret_cast<std::uintptr_t>(block) + ALIGNMENT) & ~(ALIGNMENT - 1));
+    static_cast<void **>(pointer)[-1] = block;
+    std::memset(pointer, 0, bytes);
+    return std::unique_ptr<T[], PlaneDeleter>(static_cast<T *>(pointer));
+}
+
+template<int fraction, int exponent>
+VariableFloatArray<fraction, exponent>::VariableFloatArray(std::size_t count)
+    : count(count), stride(planeStride(count)),
+      signPlane(allocatePlane<u_char>(stride)),
+      exponentPlane(allocatePlane<u_int64_t>(stride * Float::exponentLimbs * sizeof(u_int64_t))),
+      fractionPlane(allocatePlane<u_int64_t>(stride * Float::fractionLimbs * sizeof(u_int64_t)))
+{
+}
+
+template<int fraction, int exponent>
+VariableFloatArray<fraction, exponent>::VariableFloatArray(const VariableFloatArray<fraction, exponent> &other)
+    : VariableFloatArray(other.count)
+{
+    std::memcpy(signPlane.get(), other.signPlane.get(), stride);
+    std::memcpy(exponentPlane.get(), other.exponentPlane.get(), stride * Float::exponentLimbs * sizeof(u_int64_t));
+    std::memcpy(fractionPlane.get(), other.fractionPlane.get(), stride * Float::fractionLimbs * sizeof(u_int64_t));
+}
+
+template<int fraction, int exponent>
+VariableFloatArray<fraction, exponent> &
+VariableFloatArray<fraction, exponent>::operator=(const VariableFloatArray<fraction, exponent> &other)
+{
+    if (this != &other) *this = VariableFloatArray<fraction, exponent>(other);
+    return *this;
+}
+
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> VariableFloatArray<fraction, exponent>::get(std::size_t index) const
+{
+    Float value;
+    get(index, value);
+    return value;
+}
+
+template<int fraction, int exponent>
+void VariableFloatArray<fraction, exponent>::get(std::size_t index, Float &value) const
+{
+    assert(index < count);
+    typename Float::ExponentLimbs exponentLimbs;
+    typename Float::FractionLimbs fractionLimbs;
+    for (u_int j = 0; j < Float::exponentLimbs; ++j) exponentLimbs[j] = exponents(j)[index];
+    for (u_int j = 0; j < Float::fractionLimbs; ++j) fractionLimbs[j] = fractions(j)[index];
+    value.setContainers(signPlane[index] != 0, exponentLimbs, fractionLimbs);
+}
+
+template<int fraction, int exponent>
+void VariableFloatArray<fraction, exponent>::set(std::size_t index, const Float &value)
+{
+    assert(index < count);
+    signPlane[index] = value.getSign();
+    for (u_int j = 0; j < Float::exponentLimbs; ++j) exponents(j)[index] = value.getExponentContainer()[j];
+    for (u_int j = 0; j < Float::fractionLimbs; ++j) fractions(j)[index] = value.getFractionContainer()[j];
+}
+
+template<int fraction, int exponent>
+bool VariableFloatArray<fraction, exponent>::isSpecial(std::size_t index) const
+{
+    bool zero = true, ones = true;
+    for (u_int j = 0; j < Float::exponentLimbs; ++j)
+    {
+        zero &= exponents(j)[index] == 0;
+        ones &= exponents(j)[index] == Float::getInfinityExponent()[j];
+    }
+    return zero || ones;
+}
+
+template<int fraction, int exponent>
+void VariableFloatArray<fraction, exponent>::add(VariableFloatArray<fraction, exponent> &result,
+                                                 const VariableFloatArray<fraction, exponent> &n1,
+                                                 const VariableFloatArray<fraction, exponent> &n2)
+{
+    addSigned(result, n1, n2, false);
+}
+
+template<int fraction, int exponent>
+void VariableFloatArray<fraction, exponent>::subtract(VariableFloatArray<fraction, exponent> &result,
+                                                      const VariableFloatArray<fraction, exponent> &n1,
+                                                      const VariableFloatArray<fraction, exponent> &n2)
+{
+    addSigned(result, n1, n2, true);
+}
+
+template<int fraction, int exponent>
+void VariableFloatArray<fraction, exponent>::compareMagnitudes(signed char *result,
+                                                               const VariableFloatArray<fraction, exponent> &n1,
+                                                               const VariableFloatArray<fraction, exponent> &n2)
+{
+    assert(n1.size() == n2.size());
+    for (std::size_t base = 0; base < n1.size(); base += BLOCK)
+        compareBlock(result + base, n1, n2, base, std::min(BLOCK, n1.size() - base));
+}
+
+template<int fraction, int exponent>
+void VariableFloatArray<fraction, exponent>::compareBlock(signed char *result,
+                                                          const VariableFloatArray<fraction, exponent> &n1,
+                                                          const VariableFloatArray<fraction, exponent> &n2,
+                                                          std::size_t base, std::size_t count)
+{
+    signed char fractionOrder[BLOCK];
+    LimbPlanes::comparePlanes(result, n1.exponents(0) + base, n2.exponents(0) + base, Float::exponentLimbs,
+                              n1.stride, count);
+    LimbPlanes::comparePlanes(fractionOrder, n1.fractions(0) + base, n2.fractions(0) + base, Float::fractionLimbs,
+                              n1.stride, count);
+    for (std::size_t i = 0; i < count; ++i)
+        if (result[i] == 0) result[i] = fractionOrder[i];
+}
+
+template<int fraction, int exponent>
+void VariableFloatArray<fraction, exponent>::addSigned(VariableFloatArray<fraction, exponent> &result,
+                                                       const VariableFloatArray<fraction, exponent> &n1,
+                                                       const VariableFloatArray<fraction, exponent> &n2,
+                                                       bool negateSecond)
+{
+    assert(n1.size() == result.size() && n2.size() == result.size());
+    const u_int exponentSize = Float::exponentLimbs;
+    //Fractions get one additional lowest order limb for guard bits.
+    const u_int size = Float::fractionLimbs + 1;
+    const std::size_t scratchStride = SCRATCH_STRIDE;
+
+    //Lowest order significand bit that is kept after rounding and the bit below it.
+    const u_int position = size * 64 - (fraction + 1);
+    const u_int roundPosition = position - 1;
+
+    //Biggest exponent that can not overflow after normalization and rounding (both may add 1).
+    typename Float::ExponentLimbs limit = Float::getInfinityExponent();
+    LimbArray::subtractLimb(limit.data(), exponentSize, 3);
+
+    ScratchArena::Frame frame;
+    u_int64_t *higherExponent = frame.allocate(exponentSize * scratchStride);
+    u_int64_t *difference = frame.allocate(exponentSize * scratchStride);
+    u_int64_t *higherFrac = frame.allocate(size * scratchStride);
+    u_int64_t *lowerFrac = frame.allocate(size * scratchStride);
+    u_int64_t *mask = frame.allocate(scratchStride);
+    u_int64_t *carry = frame.allocate(scratchStride);
+
+    signed char order[BLOCK];
+    u_char higherSign[BLOCK];
+    u_char irregular[BLOCK];
+    u_char roundBit[BLOCK];
+    u_char lastBit[BLOCK];
+    u_int64_t shift[BLOCK];
+    u_int64_t sticky[BLOCK];
+    u_int64_t adjust[BLOCK];
+    Float number, second;
+
+    for (std::size_t base = 0; base < result.size(); base += BLOCK)
+    {
+        std::size_t count = std::min(BLOCK, result.size() - base);
+        compareBlock(order, n1, n2, base, count);
+
+        //Operand with the bigger magnitude goes to 'higher' planes, the effective operation is taken from signs.
+        //NaN, infinity and zero operands are irregular, they are added element by element at the end.
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            bool firstSign = n1.signPlane[base + i] != 0;
+            bool secondSign = (n2.signPlane[base + i] != 0) != negateSecond;
+            higherSign[i] = order[i] < 0 ? secondSign : firstSign;
+            mask[i] = firstSign != secondSign ? ~(u_int64_t) 0 : 0;
+            carry[i] = 0;
+            irregular[i] = n1.isSpecial(base + i) || n2.isSpecial(base + i);
+        }
+        for (u_int j = 0; j < exponentSize; ++j)
+        {
+            const u_int64_t *first = n1.exponents(j) + base;
+            const u_int64_t *other = n2.exponents(j) + base;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                higherExponent[j * scratchStride + i] = order[i] < 0 ? other[i] : first[i];
+                difference[j * scratchStride + i] = order[i] < 0 ? first[i] : other[i];
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            higherFrac[i] = 0;
+            lowerFrac[i] = 0;
+        }
+        for (u_int j = 1; j < size; ++j)
+        {
+            const u_int64_t *first = n1.fractions(j - 1) + base;
+            const u_int64_t *other = n2.fractions(j - 1) + base;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                higherFrac[j * scratchStride + i] = order[i] < 0 ? other[i] : first[i];
+                lowerFrac[j * scratchStride + i] = order[i] < 0 ? first[i] : other[i];
+            }
+        }
+
+        //Exponent differences, no borrow is possible.
+        LimbPlanes::subtractPlanes(difference, higherExponent, difference, carry, exponentSize, scratchStride, count);
+
+        //Elements which could overflow are irregular.
+        for (std::size_t i = 0; i < count; ++i) order[i] = 0;
+        for (u_int j = exponentSize; j-- > 0;)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                u_int64_t value = higherExponent[j * scratchStride + i];
+                if (order[i] == 0) order[i] = value > limit[j] ? 1 : (value < limit[j] ? -1 : 0);
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i) irregular[i] |= order[i] > 0;
+
+        //Align fraction of lower number with a single shift, bits shifted out are kept as a sticky bit.
+        //If exponent difference exceeds the fraction width, lower number only contributes a sticky bit.
+        for (std::size_t i = 0; i < count; ++i) shift[i] = std::min<u_int64_t>(difference[i], size * 64);
+        for (u_int j = 1; j < exponentSize; ++j)
+            for (std::size_t i = 0; i < count; ++i)
+                if (difference[j * scratchStride + i] != 0) shift[i] = size * 64;
+        LimbPlanes::shiftRightSticky(lowerFrac, shift, sticky, size, scratchStride, count);
+
+        //Different signs are subtracted as higher + ~lower + 1.
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            lowerFrac[i] |= sticky[i];
+            carry[i] = mask[i] & 1;
+        }
+
+        LimbPlanes::addPlanes(higherFrac, higherFrac, lowerFrac, mask, carry, size, scratchStride, count);
+
+        //Subtraction results are normalized with a left shift, zeros and results which underflow are irregular.
+        LimbPlanes::countLeadingZeros(shift, higherFrac, size, scratchStride, count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (mask[i] == 0) shift[i] = 0;
+            irregular[i] |= shift[i] == size * 64;
+            order[i] = 0;
+        }
+        for (u_int j = 1; j < exponentSize; ++j)
+            for (std::size_t i = 0; i < count; ++i) order[i] |= higherExponent[j * scratchStride + i] != 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            irregular[i] |= !order[i] && higherExponent[i] <= shift[i];
+            if (irregular[i]) shift[i] = 0;
+        }
+        LimbPlanes::shiftLeft(higherFrac, shift, size, scratchStride, count);
+
+        //Carry out of addition is shifted back by one bit.
+        for (std::size_t i = 0; i < count; ++i) adjust[i] = mask[i] == 0 ? carry[i] : 0;
+        LimbPlanes::shiftRightSticky(higherFrac, adjust, sticky, size, scratchStride, count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            higherFrac[i] |= sticky[i];
+            higherFrac[(size - 1) * scratchStride + i] |= adjust[i] << 63;
+        }
+
+        //Round to nearest even at the same bit of every element.
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const u_int64_t *roundLimb = higherFrac + roundPosition / 64 * scratchStride;
+            const u_int64_t *lastLimb = higherFrac + position / 64 * scratchStride;
+            bool rBit = (roundLimb[i] >> (roundPosition % 64)) & 1;
+            bool sBit = (roundLimb[i] & (((u_int64_t) 1 << (roundPosition % 64)) - 1)) != 0;
+            sticky[i] = sBit;
+            roundBit[i] = rBit;
+            lastBit[i] = (lastLimb[i] >> (position % 64)) & 1;
+        }
+        for (u_int j = 0; j < roundPosition / 64; ++j)
+            for (std::size_t i = 0; i < count; ++i) sticky[i] |= higherFrac[j * scratchStride + i] != 0;
+        for (u_int j = 0; j < position / 64; ++j)
+            for (std::size_t i = 0; i < count; ++i) higherFrac[j * scratchStride + i] = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            higherFrac[position / 64 * scratchStride + i] &= ~(((u_int64_t) 1 << (position % 64)) - 1);
+            //R = 1 and S = 1 or R = 1, S = 0 and last kept bit is odd.
+            carry[i] = roundBit[i] && (sticky[i] || lastBit[i]) ? (u_int64_t) 1 << (position % 64) : 0;
+        }
+        bool carried = true;
+        for (u_int j = position / 64; j < size && carried; ++j)
+        {
+            carried = false;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                u_int64_t &limb = higherFrac[j * scratchStride + i];
+                limb += carry[i];
+                carry[i] = limb < carry[i];
+                carried |= carry[i] != 0;
+            }
+        }
+
+        //Carry out of the container means the fraction became 1.0 * 2.
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (carry[i]) higherFrac[(size - 1) * scratchStride + i] = (u_int64_t) 1 << 63;
+            adjust[i] += carry[i];
+        }
+        for (u_int j = 0; j < exponentSize; ++j)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                u_int64_t &limb = higherExponent[j * scratchStride + i];
+                u_int64_t borrow = limb < shift[i];
+                limb -= shift[i];
+                shift[i] = borrow;
+                limb += adjust[i];
+                adjust[i] = limb < adjust[i];
+            }
+        }
+
+        //Regular results are stored directly in the planes.
+        for (std::size_t i = 0; i < count; ++i)
+            if (!irregular[i]) result.signPlane[base + i] = higherSign[i];
+        for (u_int j = 0; j < exponentSize; ++j)
+        {
+            u_int64_t *destination = result.exponents(j) + base;
+            for (std::size_t i = 0; i < count; ++i)
+                if (!irregular[i]) destination[i] = higherExponent[j * scratchStride + i];
+        }
+        for (u_int j = 0; j < Float::fractionLimbs; ++j)
+        {
+            u_int64_t *destination = result.fractions(j) + base;
+            for (std::size_t i = 0; i < count; ++i)
+                if (!irregular[i]) destination[i] = higherFrac[(j + 1) * scratchStride + i];
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (!irregular[i]) continue;
+            n1.get(base + i, number);
+            n2.get(base + i, second);
+            if (negateSecond) Float::subtract(number, number, second);
+            else Float::add(number, number, second);
+            result.set(base + i, number);
+        }
+    }
+}
+
+
+/// Elementwise operations on VariableFloatArray, the same results as the scalar vf API applied to each element.
+/// Destination must have the same size as operands and may be the same array as any operand.
+namespace vf
+{
+    /// Applies a binary scalar kernel to every element.
+    /// \param out - destination array.
+    /// \param a - first operand array.
+    /// \param b - second operand array.
+    /// \param operation - kernel storing its result in the first argument.
+    template<int fraction, int exponent, typename Operation>
+    void apply(VariableFloatArray<fraction, exponent> &out, const VariableFloatArray<fraction, exponent> &a,
+               const VariableFloatArray<fraction, exponent> &b, Operation operation)
+    {
+        assert(a.size() == out.size() && b.size() == out.size());
+        VariableFloat<fraction, exponent> x, y;
+        for (std::size_t i = 0; i < out.size(); ++i)
+        {
+            a.get(i, x);
+            b.get(i, y);
+            operation(x, x, y);
+            out.set(i, x);
+        }
+    }
+
+    /// Stores a[i] + b[i] in out[i].
+    template<int fraction, int exponent>
+    void add(VariableFloatArray<fraction, exponent> &out, const VariableFloatArray<fraction, exponent> &a,
+             const VariableFloatArray<fraction, exponent> &b)
+    {
+        VariableFloatArray<fraction, exponent>::add(out, a, b);
+    }
+
+    /// Stores a[i] - b[i] in out[i].
+    template<int fraction, int exponent>
+    void sub(VariableFloatArray<fraction, exponent> &out, const VariableFloatArray<fraction, exponent> &a,
+             const VariableFloatArray<fraction, exponent> &b)
+    {
+        VariableFloatArray<fraction, exponent>::subtract(out, a, b);
+    }
+
+    /// Stores a[i] * b[i] in out[i].
+    template<int fraction, int exponent>
+    void mul(VariableFloatArray<fraction, exponent> &out, const VariableFloatArray<fraction, exponent> &a,
+             const VariableFloatArray<fraction, exponent> &b)
+    {
+        apply(out, a, b, VariableFloat<fraction, exponent>::multiply);
+    }
+
+    /// Stores a[i] / b[i] in out[i].
+    template<int fraction, int exponent>
+    void div(VariableFloatArray<fraction, exponent> &out, const VariableFloatArray<fraction, exponent> &a,
+             const VariableFloatArray<fraction, exponent> &b)
+    {
+        apply(out, a, b, VariableFloat<fraction, exponent>::divide);
+    }
+
+    /// Stores square root of a[i] in out[i].
+    template<int fraction, int exponent>
+    void sqrt(VariableFloatArray<fraction, exponent> &out, const VariableFloatArray<fraction, exponent> &a)
+    {
+        assert(a.size() == out.size());
+        VariableFloat<fraction, exponent> x;
+        for (std::size_t i = 0; i < out.size(); ++i)
+        {
+            a.get(i, x);
+            VariableFloat<fraction, exponent>::sqrt(x, x);
+            out.set(i, x);
+        }
+    }
+
+    /// Stores a[i] * factor in out[i].
+    template<int fraction, int exponent>
+    void scale(VariableFloatArray<fraction, exponent> &out, const VariableFloatArray<fraction, exponent> &a,
+               const VariableFloat<fraction, exponent> &factor)
+    {
+        assert(a.size() == out.size());
+        VariableFloat<fraction, exponent> x;
+        for (std::size_t i = 0; i < out.size(); ++i)
+        {
+            a.get(i, x);
+            VariableFloat<fraction, exponent>::multiply(x, x, factor);
+            out.set(i, x);
+        }
+    }
+
+    /// Computes y[i] = alpha * x[i] + y[i], rounded once per element.
+    template<int fraction, int exponent>
+    void axpy(VariableFloatArray<fraction, exponent> &y, const VariableFloat<fraction, exponent> &alpha,
+              const VariableFloatArray<fraction, exponent> &x)
+    {
+        assert(x.size() == y.size());
+        VariableFloat<fraction, exponent> a, b;
+        for (std::size_t i = 0; i < y.size(); ++i)
+        {
+            x.get(i, a);
+            y.get(i, b);
+            VariableFloat<fraction, exponent>::fma(b, alpha, a, b);
+            y.set(i, b);
+        }
+    }
+}
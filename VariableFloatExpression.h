@@ -0,0 +1,380 @@
+#pragma once
+
+#include <type_traits>
+
+#include "DeferredAccumulator.h"
+#include "VariableFloat.h"
+
+/// Opt-in expression templates over VariableFloat.
+/// Operands wrapped with vf::lazy build an expression tree at compile time, nothing is computed until the expression
+/// is converted to a VariableFloat (or evaluated into one with vf::evaluate). Evaluation is a single pass that keeps
+/// intermediates on the stack:
+/// - a product plus or minus another operand is computed with a single rounding (fma),
+/// - sums of three or more terms, or of two products, are added in a DeferredAccumulator wide enough to hold exact
+///   products whole (formats with exponents of up to 62 bits, wider ones round every addition). A sum of two products
+///   is rounded once. Longer sums are rounded once unless bits of a term fall more than 'fractionLimbs' + 1 limbs
+///   below the fraction of the running sum, then the result is within the DeferredAccumulator error bound,
+/// - products, quotients and negations of other nodes round once per operation, like VariableFloat operators.
+/// Leaves refer to their operands, so an expression has to be evaluated while the operands exist.
+namespace vf
+{
+    namespace expression
+    {
+        /// Properties of a VariableFloat representation used by expression nodes.
+        template<typename Float>
+        struct Traits;
+
+        template<int fraction, int exponent>
+        struct Traits<VariableFloat<fraction, exponent>>
+        {
+            /// Accumulator of sums of more than two terms, with guard limbs below the fraction for exact products.
+            typedef DeferredAccumulator<fraction, exponent, VariableFloat<fraction, exponent>::fractionLimbs + 1>
+                    Accumulator;
+
+            /// Whether sums of more than two terms are accumulated (DeferredAccumulator supports the exponent).
+            static constexpr bool ACCUMULATED = exponent <= 62;
+        };
+
+        template<int fraction, int exponent>
+        constexpr bool Traits<VariableFloat<fraction, exponent>>::ACCUMULATED;
+
+        /// Base of all expression nodes.
+        /// \tparam Derived - node type.
+        /// \tparam Number - VariableFloat type the expression evaluates to.
+        template<typename Derived, typename Number>
+        class Expression
+        {
+        public:
+            typedef Number Float;
+
+            /// Returns the node as its derived type.
+            /// \return Reference to the derived node.
+            const Derived &self() const { return static_cast<const Derived &>(*this); }
+
+            /// Evaluates the expression.
+            /// \return Value of the expression.
+            Float value() const
+            {
+                Float result;
+                self().evaluate(result);
+                return result;
+            }
+
+            /// Evaluates the expression on conversion (e.g. on assignment to a VariableFloat).
+            operator Float() const { return value(); }
+        };
+
+        /// Reference to a VariableFloat operand.
+        template<int fraction, int exponent>
+        class Leaf : public Expression<Leaf<fraction, exponent>, VariableFloat<fraction, exponent>>
+        {
+        public:
+            typedef VariableFloat<fraction, exponent> Float;
+            typedef typename Traits<Float>::Accumulator Accumulator;
+
+            /// Number of terms of the node as a sum, number of products among them, whether the node is a product.
+            static constexpr int TERMS = 1;
+            static constexpr int PRODUCTS = 0;
+            static constexpr bool PRODUCT = false;
+
+            explicit Leaf(const Float &operand) : number(operand) {}
+
+            /// Returns the operand (no copy).
+            /// \return Reference to the operand.
+            const Float &value() const { return number; }
+
+            /// Stores the operand in 'out'.
+            void evaluate(Float &out) const { out = number; }
+
+            /// Adds the operand (or subtracts it if 'negate' is set) to a running sum.
+            void accumulate(Accumulator &sum, bool negate) const
+            {
+                if (negate) sum.subtract(number);
+                else sum.add(number);
+            }
+
+        private:
+            const Float &number;
+        };
+
+        /// Product of two nodes.
+        template<typename L, typename R>
+        class Product : public Expression<Product<L, R>, typename L::Float>
+        {
+        public:
+            typedef typename L::Float Float;
+            typedef typename Traits<Float>::Accumulator Accumulator;
+
+            static constexpr int TERMS = 1;
+            static constexpr int PRODUCTS = 1;
+            static constexpr bool PRODUCT = true;
+
+            Product(const L &first, const R &second) : left(first), right(second) {}
+
+            /// Stores the rounded product in 'out'.
+            void evaluate(Float &out) const { Float::multiply(out, left.value(), right.value()); }
+
+            /// Adds the unrounded product (or subtracts it if 'negate' is set) to a running sum.
+            void accumulate(Accumulator &sum, bool negate) const
+            {
+                if (negate) sum.subtractProduct(left.value(), right.value());
+                else sum.addProduct(left.value(), right.value());
+            }
+
+            /// Stores the product (negated if 'negate' is set) plus 'addend' rounded once in 'out'.
+            void fusedMultiplyAdd(Float &out, const Float &addend, bool negate) const
+            {
+                Float first = left.value();
+                if (negate) first.setSign(!first.getSign());
+                Float::fma(out, first, right.value(), addend);
+            }
+
+        private:
+            const L left;
+            const R right;
+        };
+
+        /// Quotient of two nodes.
+        template<typename L, typename R>
+        class Quotient : public Expression<Quotient<L, R>, typename L::Float>
+        {
+        public:
+            typedef typename L::Float Float;
+            typedef typename Traits<Float>::Accumulator Accumulator;
+
+            static constexpr int TERMS = 1;
+            static constexpr int PRODUCTS = 0;
+            static constexpr bool PRODUCT = false;
+
+            Quotient(const L &first, const R &second) : left(first), right(second) {}
+
+            /// Stores the rounded quotient in 'out'.
+            void evaluate(Float &out) const { Float::divide(out, left.value(), right.value()); }
+
+            /// Adds the rounded quotient (or subtracts it if 'negate' is set) to a running sum.
+            void accumulate(Accumulator &sum, bool negate) const
+            {
+                Float quotient;
+                evaluate(quotient);
+                if (negate) sum.subtract(quotient);
+                else sum.add(quotient);
+            }
+
+        private:
+            const L left;
+            const R right;
+        };
+
+        /// Negation of a node.
+        template<typename E>
+        class Negation : public Expression<Negation<E>, typename E::Float>
+        {
+        public:
+            typedef typename E::Float Float;
+            typedef typename Traits<Float>::Accumulator Accumulator;
+
+            static constexpr int TERMS = E::TERMS;
+            static constexpr int PRODUCTS = E::PRODUCTS;
+            static constexpr bool PRODUCT = E::PRODUCT;
+
+            explicit Negation(const E &operand) : node(operand) {}
+
+            /// Stores the negated node value in 'out'.
+            void evaluate(Float &out) const
+            {
+                node.evaluate(out);
+                out.setSign(!out.getSign());
+            }
+
+            /// Adds terms of the node with inverted signs to a running sum.
+            void accumulate(Accumulator &sum, bool negate) const { node.accumulate(sum, !negate); }
+
+            /// Stores the negated product plus 'addend' rounded once in 'out' (the node has to be a product).
+            void fusedMultiplyAdd(Float &out, const Float &addend, bool negate) const
+            {
+                node.fusedMultiplyAdd(out, addend, !negate);
+            }
+
+        private:
+            const E node;
+        };
+
+        /// Sum or difference of two nodes.
+        template<typename L, typename R, bool difference>
+        class Sum : public Expression<Sum<L, R, difference>, typename L::Float>
+        {
+        public:
+            typedef typename L::Float Float;
+            typedef typename Traits<Float>::Accumulator Accumulator;
+
+            static constexpr int TERMS = L::TERMS + R::TERMS;
+            static constexpr int PRODUCTS = L::PRODUCTS + R::PRODUCTS;
+            static constexpr bool PRODUCT = false;
+
+            Sum(const L &first, const R &second) : left(first), right(second) {}
+
+            /// Evaluates the sum with a single rounding where possible.
+            void evaluate(Float &out) const { evaluate(out, std::integral_constant<Method, method()>()); }
+
+            /// Adds terms of both nodes to a running sum.
+            void accumulate(Accumulator &sum, bool negate) const
+            {
+                left.accumulate(sum, negate);
+                right.accumulate(sum, negate != difference);
+            }
+
+        private:
+            const L left;
+            const R right;
+
+            enum class Method
+            {
+                Rounded,
+                FusedLeft,
+                FusedRight,
+                Accumulated
+            };
+
+            /// Chooses the evaluation method from the shape of the tree.
+            static constexpr Method method()
+            {
+                return TERMS == 2 && L::PRODUCT && R::PRODUCTS == 0 ? Method::FusedLeft :
+                       TERMS == 2 && R::PRODUCT && L::PRODUCTS == 0 ? Method::FusedRight :
+                       TERMS == 2 && PRODUCTS == 0 ? Method::Rounded :
+                       Traits<Float>::ACCUMULATED ? Method::Accumulated : Method::Rounded;
+            }
+
+            //Two terms without products (or a format without an accumulator): operands are rounded separately.
+            void evaluate(Float &out, std::integral_constant<Method, Method::Rounded>) const
+            {
+                if (difference) Float::subtract(out, left.value(), right.value());
+                else Float::add(out, left.value(), right.value());
+            }
+
+            //x * y + r, x * y - r.
+            void evaluate(Float &out, std::integral_constant<Method, Method::FusedLeft>) const
+            {
+                Float addend = right.value();
+                if (difference) addend.setSign(!addend.getSign());
+                left.fusedMultiplyAdd(out, addend, false);
+            }
+
+            //l + x * y, l - x * y.
+            void evaluate(Float &out, std::integral_constant<Method, Method::FusedRight>) const
+            {
+                right.fusedMultiplyAdd(out, left.value(), difference);
+            }
+
+            //Longer sums and sums of two products: all terms are added unrounded, the sum is rounded when read.
+            void evaluate(Float &out, std::integral_constant<Method, Method::Accumulated>) const
+            {
+                Accumulator sum;
+                accumulate(sum, false);
+                sum.result(out);
+            }
+        };
+
+        /// Operators building expression nodes from expressions and VariableFloat operands.
+        template<typename L, typename R, typename F>
+        Sum<L, R, false> operator+(const Expression<L, F> &n1, const Expression<R, F> &n2)
+        {
+            return Sum<L, R, false>(n1.self(), n2.self());
+        }
+
+        template<typename L, int fraction, int exponent>
+        Sum<L, Leaf<fraction, exponent>, false> operator+(const Expression<L, VariableFloat<fraction, exponent>> &n1,
+                                                          const VariableFloat<fraction, exponent> &n2)
+        {
+            return Sum<L, Leaf<fraction, exponent>, false>(n1.self(), Leaf<fraction, exponent>(n2));
+        }
+
+        template<typename R, int fraction, int exponent>
+        Sum<Leaf<fraction, exponent>, R, false> operator+(const VariableFloat<fraction, exponent> &n1,
+                                                          const Expression<R, VariableFloat<fraction, exponent>> &n2)
+        {
+            return Sum<Leaf<fraction, exponent>, R, false>(Leaf<fraction, exponent>(n1), n2.self());
+        }
+
+        template<typename L, typename R, typename F>
+        Sum<L, R, true> operator-(const Expression<L, F> &n1, const Expression<R, F> &n2)
+        {
+            return Sum<L, R, true>(n1.self(), n2.self());
+        }
+
+        template<typename L, int fraction, int exponent>
+        Sum<L, Leaf<fraction, exponent>, true> operator-(const Expression<L, VariableFloat<fraction, exponent>> &n1,
+                                                         const VariableFloat<fraction, exponent> &n2)
+        {
+            return Sum<L, Leaf<fraction, exponent>, true>(n1.self(), Leaf<fraction, exponent>(n2));
+        }
+
+        template<typename R, int fraction, int exponent>
+        Sum<Leaf<fraction, exponent>, R, true> operator-(const VariableFloat<fraction, exponent> &n1,
+                                                         const Expression<R, VariableFloat<fraction, exponent>> &n2)
+        {
+            return Sum<Leaf<fraction, exponent>, R, true>(Leaf<fraction, exponent>(n1), n2.self());
+        }
+
+        template<typename L, typename R, typename F>
+        Product<L, R> operator*(const Expression<L, F> &n1, const Expression<R, F> &n2)
+        {
+            return Product<L, R>(n1.self(), n2.self());
+        }
+
+        template<typename L, int fraction, int exponent>
+        Product<L, Leaf<fraction, exponent>> operator*(const Expression<L, VariableFloat<fraction, exponent>> &n1,
+                                                       const VariableFloat<fraction, exponent> &n2)
+        {
+            return Product<L, Leaf<fraction, exponent>>(n1.self(), Leaf<fraction, exponent>(n2));
+        }
+
+        template<typename R, int fraction, int exponent>
+        Product<Leaf<fraction, exponent>, R> operator*(const VariableFloat<fraction, exponent> &n1,
+                                                       const Expression<R, VariableFloat<fraction, exponent>> &n2)
+        {
+            return Product<Leaf<fraction, exponent>, R>(Leaf<fraction, exponent>(n1), n2.self());
+        }
+
+        template<typename L, typename R, typename F>
+        Quotient<L, R> operator/(const Expression<L, F> &n1, const Expression<R, F> &n2)
+        {
+            return Quotient<L, R>(n1.self(), n2.self());
+        }
+
+        template<typename L, int fraction, int exponent>
+        Quotient<L, Leaf<fraction, exponent>> operator/(const Expression<L, VariableFloat<fraction, exponent>> &n1,
+                                                        const VariableFloat<fraction, exponent> &n2)
+        {
+            return Quotient<L, Leaf<fraction, exponent>>(n1.self(), Leaf<fraction, exponent>(n2));
+        }
+
+        template<typename R, int fraction, int exponent>
+        Quotient<Leaf<fraction, exponent>, R> operator/(const VariableFloat<fraction, exponent> &n1,
+                                                        const Expression<R, VariableFloat<fraction, exponent>> &n2)
+        {
+            return Quotient<Leaf<fraction, exponent>, R>(Leaf<fraction, exponent>(n1), n2.self());
+        }
+
+        template<typename E, typename F>
+        Negation<E> operator-(const Expression<E, F> &n)
+        {
+            return Negation<E>(n.self());
+        }
+    }
+
+    /// Wraps a number, so that operators applied to it build an expression instead of computing temporaries.
+    /// \param number - operand, must exist until the expression is evaluated.
+    /// \return Expression leaf referring to 'number'.
+    template<int fraction, int exponent>
+    expression::Leaf<fraction, exponent> lazy(const VariableFloat<fraction, exponent> &number)
+    {
+        return expression::Leaf<fraction, exponent>(number);
+    }
+
+    /// Evaluates an expression into 'out' (which may be one of its operands).
+    template<typename E, typename F>
+    void evaluate(F &out, const expression::Expression<E, F> &tree)
+    {
+        tree.self().evaluate(out);
+    }
+}
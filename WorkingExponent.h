@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "LimbArray.h"
+
+template<int bits, bool native = (bits <= 62)>
+/// Signed exponent used during computation: biased exponents of a format with 'bits' exponent bits, their sums,
+/// differences and normalization adjustments. Wider exponents are held in a two's complement limb container with
+/// one additional limb, exponents of up to 62 bits in a long long (specialization below), so that every operation
+/// is a single integer instruction.
+/// \tparam bits - exponent bit count.
+/// \tparam native - long long representation.
+class WorkingExponent
+{
+public:
+    /// Stored exponent size in limbs.
+    static constexpr u_int LIMBS = (bits / 64) + 1;
+
+    /// Two's complement limb container of the value.
+    typedef std::array<u_int64_t, LIMBS + 1> Limbs;
+
+    /// Creates an exponent equal to zero.
+    WorkingExponent() = default;
+
+    /// Creates an exponent from a stored (non-negative) exponent container.
+    /// \param stored - exponent container of 'LIMBS' limbs.
+    explicit WorkingExponent(const std::array<u_int64_t, LIMBS> &stored)
+    {
+        std::copy(stored.begin(), stored.end(), limbs.begin());
+    }
+
+    /// Creates an exponent from a two's complement limb container.
+    /// \param value - limb container.
+    /// \return Exponent equal to 'value'.
+    static WorkingExponent fromLimbs(const Limbs &value)
+    {
+        WorkingExponent result;
+        result.limbs = value;
+        return result;
+    }
+
+    /// Returns the two's complement limb container of the exponent.
+    /// \return Limb container.
+    Limbs toLimbs() const { return limbs; }
+
+    /// Stores the lowest order limbs of the exponent in an exponent container.
+    /// \param stored - exponent container of 'LIMBS' limbs.
+    void store(std::array<u_int64_t, LIMBS> &stored) const
+    {
+        std::copy(limbs.begin(), limbs.begin() + LIMBS, stored.begin());
+    }
+
+    /// Adds a signed value to the exponent.
+    /// \param value - value to be added.
+    void add(long long value)
+    {
+        if (value >= 0) LimbArray::addLimb(limbs.data(), LIMBS + 1, (u_int64_t) value);
+        else LimbArray::subtractLimb(limbs.data(), LIMBS + 1, -(u_int64_t) value);
+    }
+
+    /// Adds an exponent to the exponent.
+    /// \param value - exponent to be added.
+    void add(const WorkingExponent &value) { LimbArray::addLimbs(limbs.data(), value.limbs.data(), LIMBS + 1); }
+
+    /// Subtracts an exponent from the exponent.
+    /// \param value - exponent to be subtracted.
+    void subtract(const WorkingExponent &value)
+    {
+        LimbArray::subtractLimbs(limbs.data(), value.limbs.data(), LIMBS + 1);
+    }
+
+    /// Halves the exponent (arithmetic shift right).
+    void halve()
+    {
+        u_int64_t signLimb = limbs[LIMBS] & ((u_int64_t) 1 << 63);
+        LimbArray::shiftRight(limbs.data(), LIMBS + 1, 1);
+        limbs[LIMBS] |= signLimb;
+    }
+
+    /// Checks whether the exponent is negative.
+    /// \return true if negative, otherwise false.
+    bool isNegative() const { return limbs[LIMBS] >> 63; }
+
+    /// Checks whether the exponent lies in [0, bound).
+    /// \param bound - upper bound.
+    /// \return true if it does, otherwise false.
+    bool isBelow(u_int64_t bound) const
+    {
+        return LimbArray::checkIfZero(limbs.data() + 1, LIMBS) && limbs[0] < bound;
+    }
+
+    /// Returns the lowest order limb of the exponent (its value if it lies in [0, 2^64)).
+    /// \return Lowest order limb.
+    u_int64_t getLow() const { return limbs[0]; }
+
+    /// Compares the exponent with a stored exponent container.
+    /// \param stored - exponent container of 'LIMBS' limbs.
+    /// \return 0 if equal, -1 if 'stored' is greater and 1 if the exponent is greater.
+    int compare(const std::array<u_int64_t, LIMBS> &stored) const
+    {
+        //Negative exponent or one with an extended range.
+        if (isNegative()) return -1;
+        else if (limbs[LIMBS] != 0) return 1;
+        return LimbArray::compare(limbs.data(), stored.data(), LIMBS);
+    }
+
+private:
+    /// Two's complement exponent container.
+    Limbs limbs{};
+};
+
+template<int bits>
+/// Working exponent of up to 62 bits held in a long long. Biased exponents are below 2^62, so their sums and
+/// differences fit, additions saturate instead of wrapping around (the result then overflows or underflows).
+/// \tparam bits - exponent bit count.
+class WorkingExponent<bits, true>
+{
+public:
+    /// Stored exponent size in limbs.
+    static constexpr u_int LIMBS = 1;
+
+    /// Two's complement limb container of the value.
+    typedef std::array<u_int64_t, LIMBS + 1> Limbs;
+
+    /// Creates an exponent equal to zero.
+    WorkingExponent() = default;
+
+    /// Creates an exponent from a stored (non-negative) exponent container.
+    /// \param stored - exponent container of a single limb.
+    explicit WorkingExponent(const std::array<u_int64_t, LIMBS> &stored) : value((long long) stored[0]) {}
+
+    /// Creates an exponent from a two's complement limb container (the value must fit in a long long).
+    /// \param source - limb container.
+    /// \return Exponent equal to 'source'.
+    static WorkingExponent fromLimbs(const Limbs &source)
+    {
+        WorkingExponent result;
+        result.value = (long long) source[0];
+        return result;
+    }
+
+    /// Returns the two's complement limb container of the exponent.
+    /// \return Limb container.
+    Limbs toLimbs() const { return {{(u_int64_t) value, value < 0 ? ~(u_int64_t) 0 : 0}}; }
+
+    /// Stores the exponent in an exponent container.
+    /// \param stored - exponent container of a single limb.
+    void store(std::array<u_int64_t, LIMBS> &stored) const { stored[0] = (u_int64_t) value; }
+
+    /// Adds a signed value to the exponent.
+    /// \param operand - value to be added.
+    void add(long long operand)
+    {
+        if (__builtin_add_overflow(value, operand, &value)) value = saturate(operand > 0);
+    }
+
+    /// Adds an exponent to the exponent.
+    /// \param operand - exponent to be added.
+    void add(const WorkingExponent &operand) { add(operand.value); }
+
+    /// Subtracts an exponent from the exponent.
+    /// \param operand - exponent to be subtracted.
+    void subtract(const WorkingExponent &operand)
+    {
+        if (__builtin_sub_overflow(value, operand.value, &value)) value = saturate(operand.value < 0);
+    }
+
+    /// Halves the exponent (arithmetic shift right).
+    void halve() { value >>= 1; }
+
+    /// Checks whether the exponent is negative.
+    /// \return true if negative, otherwise false.
+    bool isNegative() const { return value < 0; }
+
+    /// Checks whether the exponent lies in [0, bound).
+    /// \param bound - upper bound.
+    /// \return true if it does, otherwise false.
+    bool isBelow(u_int64_t bound) const { return value >= 0 && (u_int64_t) value < bound; }
+
+    /// Returns the lowest order limb of the exponent (its value if it lies in [0, 2^64)).
+    /// \return Lowest order limb.
+    u_int64_t getLow() const { return (u_int64_t) value; }
+
+    /// Compares the exponent with a stored exponent container.
+    /// \param stored - exponent container of a single limb.
+    /// \return 0 if equal, -1 if 'stored' is greater and 1 if the exponent is greater.
+    int compare(const std::array<u_int64_t, LIMBS> &stored) const
+    {
+        const auto other = (long long) stored[0];
+        return value > other ? 1 : (value < other ? -1 : 0);
+    }
+
+private:
+    /// Exponent value.
+    long long value = 0;
+
+    /// Returns the bound a saturated operation stops at.
+    /// \param positive - true if the operation overflowed upwards.
+    static long long saturate(bool positive)
+    {
+        return positive ? std::numeric_limits<long long>::max() : std::numeric_limits<long long>::min();
+    }
+};
+
+template<int bits, bool native>
+constexpr u_int WorkingExponent<bits, native>::LIMBS;
+
+template<int bits>
+constexpr u_int WorkingExponent<bits, true>::LIMBS;
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <iomanip>
+#include <climits>
 #include "VariableFloat.h"
+#include "VariableFloatArray.h"
 #include "util/Timer.h"
 #include "test/Test.h"
 #include "test/AddTest.h"
@@ -8,6 +10,11 @@
 #include "test/MulTest.h"
 #include "test/DivTest.h"
 #include "test/SqrtTest.h"
+#include "test/ParallelTest.h"
+#include "test/FmaTest.h"
+#include "test/SumTest.h"
+#include "test/ExpressionTest.h"
+#include "test/MultiDoubleTest.h"
 
 #define addUnitTest(a,b)  {VariableFloat<a, b> data[populationSize]; \
                           AddTest<a,b> add(data); \
@@ -34,6 +41,133 @@
                            fillArray(data, populationSize, randomFloats); \
                            runTest(add, data, populationSize); }
 
+#define addOutUnitTest(a,b)  {VariableFloat<a, b> data[populationSize]; \
+                             AddOutTest<a,b> add(data); \
+                             fillArray(data, populationSize, randomFloats); \
+                             runTest(add, data, populationSize); }
+
+#define mulOutUnitTest(a,b)  {VariableFloat<a, b> data[populationSize]; \
+                             MulOutTest<a,b> add(data); \
+                             fillArray(data, populationSize, randomFloats); \
+                             runTest(add, data, populationSize); }
+
+#define fmaUnitTest(a,b)  {VariableFloat<a, b> data[populationSize]; \
+                          fillArray(data, populationSize, randomFloats); \
+                          std::cerr<<"Mnozenie i dodawanie - fma"<<std::endl; \
+                          FmaTest<a,b> fused(data, populationSize); \
+                          runTest(fused, data, populationSize); \
+                          std::cerr<<"Mnozenie i dodawanie - vf::mul, vf::add"<<std::endl; \
+                          MulAddTest<a,b> separate(data, populationSize); \
+                          runTest(separate, data, populationSize); }
+
+#define sumUnitTest(a,b)  {std::vector<VariableFloat<a, b>> data(sumSize); \
+                          fillArray(data.data(), sumSize, randomFloats); \
+                          std::cerr<<"Sumowanie - operator+"<<std::endl; \
+                          SumTest<a,b> rounded(data.data(), sumSize, SumMethod::Rounded); \
+                          runTest(rounded, data.data(), 2 * sumRepeats); \
+                          std::cerr<<"Sumowanie - akumulator dokladny"<<std::endl; \
+                          SumTest<a,b> exact(data.data(), sumSize, SumMethod::Exact); \
+                          runTest(exact, data.data(), 2 * sumRepeats); \
+                          std::cerr<<"Sumowanie - odroczona normalizacja"<<std::endl; \
+                          SumTest<a,b> deferred(data.data(), sumSize, SumMethod::Deferred); \
+                          runTest(deferred, data.data(), 2 * sumRepeats); }
+
+#define expressionUnitTest(a,b)  {VariableFloat<a, b> data[populationSize]; \
+                                 fillArray(data, populationSize, randomFloats); \
+                                 std::cerr<<"Wyrazenie a*b+c*d-e - operatory"<<std::endl; \
+                                 OperatorExpressionTest<a,b> eager(data, populationSize); \
+                                 runTest(eager, data, populationSize); \
+                                 std::cerr<<"Wyrazenie a*b+c*d-e - vf::lazy"<<std::endl; \
+                                 ExpressionTest<a,b> lazy(data, populationSize); \
+                                 runTest(lazy, data, populationSize); }
+
+#define outParamUnitTest(a,b)  {std::cerr<<"Dodawanie - operator"<<std::endl; \
+                               addUnitTest(a,b); \
+                               std::cerr<<"Dodawanie - vf::add"<<std::endl; \
+                               addOutUnitTest(a,b); \
+                               std::cerr<<"Mnozenie - operator"<<std::endl; \
+                               mulUnitTest(a,b); \
+                               std::cerr<<"Mnozenie - vf::mul"<<std::endl; \
+                               mulOutUnitTest(a,b); }
+
+#define mulKernelUnitTest(a,b)  {std::cerr<<"Mnozenie szkolne"<<std::endl; \
+                                setMultiplicationThresholds(UINT_MAX, UINT_MAX); \
+                                mulUnitTest(a,b); \
+                                std::cerr<<"Mnozenie Karatsuby"<<std::endl; \
+                                setMultiplicationThresholds(karatsubaThreshold, UINT_MAX); \
+                                mulUnitTest(a,b); \
+                                std::cerr<<"Mnozenie NTT"<<std::endl; \
+                                setMultiplicationThresholds(karatsubaThreshold, 0); \
+                                mulUnitTest(a,b); \
+                                setMultiplicationThresholds(karatsubaThreshold, transformThreshold); }
+
+#define carryKernelUnitTest(a,b)  {std::cerr<<"Jadra przenosne"<<std::endl; \
+                                 LimbArray::setKernel(LimbArray::Kernel::Portable); \
+                                 addUnitTest(a,b); \
+                                 mulUnitTest(a,b); \
+                                 std::cerr<<"Jadra "<<LimbArray::getKernelName(detectedKernel)<<std::endl; \
+                                 LimbArray::setKernel(detectedKernel); \
+                                 addUnitTest(a,b); \
+                                 mulUnitTest(a,b); }
+
+#define scalingUnitTest(a,b)  {for (u_int threads = 1; ; threads *= 2) \
+                             { \
+                                 ThreadPool pool(std::min(threads, maxThreads)); \
+                                 LimbArray::threadPool = &pool; \
+                                 std::cerr<<"Watki: "<<pool.getThreadCount()<<std::endl; \
+                                 std::cout<<"watki                           : "<<pool.getThreadCount()<<std::endl; \
+                                 mulUnitTest(a,b); \
+                                 divUnitTest(a,b); \
+                                 if (threads >= maxThreads) break; \
+                             } \
+                             LimbArray::threadPool = nullptr; }
+
+#define addBatchUnitTest(a,b)  {VariableFloatArray<a, b> first(batchSize), second(batchSize); \
+                               fillArray(first, firstFloats); \
+                               fillArray(second, secondFloats); \
+                               AddBatchTest<a,b> element(first, second, true); \
+                               AddBatchTest<a,b> batch(first, second, false); \
+                               runBatchTest<a,b>(element, batch, batchRepeats); }
+
+#define subBatchUnitTest(a,b)  {VariableFloatArray<a, b> first(batchSize), second(batchSize); \
+                               fillArray(first, firstFloats); \
+                               fillArray(second, secondFloats); \
+                               SubBatchTest<a,b> element(first, second, true); \
+                               SubBatchTest<a,b> batch(first, second, false); \
+                               runBatchTest<a,b>(element, batch, batchRepeats); }
+
+#define parallelUnitTest(a,b)  {for (BatchCost operation : {BatchCost::Add, BatchCost::Multiply, BatchCost::Divide, \
+                                                     BatchCost::SquareRoot, BatchCost::Fma}) \
+                               { \
+                                   ParallelTest<a,b> test(firstFloats, secondFloats, operation); \
+                                   runParallelTest<a,b>(test, operation, parallelRepeats); \
+                               } }
+
+#define multiDoubleUnitTest(a,b)  {VariableFloat<a, b> data[2]; \
+                                  for (BatchCost operation : {BatchCost::Add, BatchCost::Multiply, BatchCost::Divide, \
+                                                              BatchCost::SquareRoot}) \
+                                  { \
+                                      std::cerr<<operationNames[(int) operation]<<" - VariableFloat"<<std::endl; \
+                                      MultiDoubleTest<a,b> limbs(firstFloats, secondFloats, operation, \
+                                                                 MultiDoubleMethod::VariableFloat); \
+                                      runTest(limbs, data, 2 * multiDoubleRepeats); \
+                                      std::cerr<<operationNames[(int) operation]<<" - konwersja do MultiDouble<" \
+                                               <<MultiDoubleArithmetic<a,b>::TERMS<<">"<<std::endl; \
+                                      MultiDoubleTest<a,b> converted(firstFloats, secondFloats, operation, \
+                                                                     MultiDoubleMethod::Converted); \
+                                      runTest(converted, data, 2 * multiDoubleRepeats); \
+                                      std::cerr<<operationNames[(int) operation]<<" - MultiDouble<" \
+                                               <<MultiDoubleArithmetic<a,b>::TERMS<<">"<<std::endl; \
+                                      MultiDoubleTest<a,b> kept(firstFloats, secondFloats, operation, \
+                                                                MultiDoubleMethod::Kept); \
+                                      runTest(kept, data, 2 * multiDoubleRepeats); \
+                                  } }
+
+void setMultiplicationThresholds(u_int karatsuba, u_int transform)
+{
+    LimbArray::karatsubaThreshold = karatsuba;
+    LimbArray::transformThreshold = transform;
+}
 
 template<int fraction, int exponent>
 Test::TestResult runTest(UnitTimeTest& testObj, VariableFloat<fraction, exponent> data[], int size)
@@ -49,11 +183,77 @@ Test::TestResult runTest(UnitTimeTest& testObj, VariableFloat<fraction, exponent
     std::cout<<"czas calosciowy testow          : "<<std::fixed<<result.fullTime<<std::endl;
     std::cout<<"sredni czas wykonania           : "<<std::fixed<<result.avgTimePerTest<<std::endl;
     std::cout<<"czas testow (bez after i before): "<<std::fixed<<result.fullTimeOfTests<<std::endl;
+    std::cout<<"ilosc alokacji w testach        : "<<result.allocations<<std::endl;
 
     result.toCsv(std::cerr);
     return result;
 }
 
+/// Runs a batch test element by element, then with scalar and vector LimbPlanes kernels, and reports speedups.
+template<int fraction, int exponent>
+void runBatchTest(UnitTimeTest &elementTest, UnitTimeTest &batchTest, int repeats)
+{
+    Test t;
+    const LimbPlanes::Isa detected = LimbPlanes::detectIsa();
+
+    std::cerr<<"Element po elemencie"<<std::endl;
+    Test::TestResult element = t.createTest(elementTest, repeats);
+
+    std::cerr<<"Wsadowo - skalarne"<<std::endl;
+    LimbPlanes::setIsa(LimbPlanes::Isa::Scalar);
+    Test::TestResult scalar = t.createTest(batchTest, repeats);
+
+    std::cerr<<"Wsadowo - "<<LimbPlanes::getIsaName(detected)<<std::endl;
+    LimbPlanes::setIsa(detected);
+    Test::TestResult vector = t.createTest(batchTest, repeats);
+
+    for (Test::TestResult *result : {&element, &scalar, &vector})
+    {
+        result->exponent = exponent;
+        result->fraction = fraction;
+        result->toCsv(std::cerr);
+    }
+
+    std::cout<<"mantysa, wykladnik              : "<<fraction<<", "<<exponent<<std::endl;
+    std::cout<<"czas element po elemencie       : "<<std::fixed<<element.avgTimePerTest<<std::endl;
+    std::cout<<"czas wsadowo (skalarne)         : "<<std::fixed<<scalar.avgTimePerTest<<std::endl;
+    std::cout<<"czas wsadowo (wektorowe)        : "<<std::fixed<<vector.avgTimePerTest<<std::endl;
+    std::cout<<"instrukcje wektorowe            : "<<LimbPlanes::getIsaName(detected)<<std::endl;
+    std::cout<<"przyspieszenie (skalarne)       : "<<std::fixed<<element.avgTimePerTest / scalar.avgTimePerTest<<std::endl;
+    std::cout<<"przyspieszenie (wektorowe)      : "<<std::fixed<<element.avgTimePerTest / vector.avgTimePerTest<<std::endl;
+}
+
+/// Runs a parallel batch test on a single thread and on the global pool, and reports the speedup.
+template<int fraction, int exponent>
+void runParallelTest(ParallelTest<fraction, exponent> &parallelTest, BatchCost operation, int repeats)
+{
+    static const char *const names[] = {"dodawanie", "mnozenie", "dzielenie", "pierwiastek", "fma"};
+    Test t;
+    ThreadPool single(1);
+
+    std::cerr<<"Jeden watek - "<<names[static_cast<int>(operation)]<<std::endl;
+    parallelTest.setPool(single);
+    Test::TestResult serial = t.createTest(parallelTest, repeats);
+
+    std::cerr<<"Watki: "<<ThreadPool::global().getThreadCount()<<" - "<<names[static_cast<int>(operation)]<<std::endl;
+    parallelTest.setPool(ThreadPool::global());
+    Test::TestResult parallel = t.createTest(parallelTest, repeats);
+
+    for (Test::TestResult *result : {&serial, &parallel})
+    {
+        result->exponent = exponent;
+        result->fraction = fraction;
+        result->toCsv(std::cerr);
+    }
+
+    std::cout<<"mantysa, wykladnik, operacja    : "<<fraction<<", "<<exponent<<", "
+             <<names[static_cast<int>(operation)]<<std::endl;
+    std::cout<<"czas jeden watek                : "<<std::fixed<<serial.avgTimePerTest<<std::endl;
+    std::cout<<"czas wszystkie watki            : "<<std::fixed<<parallel.avgTimePerTest<<std::endl;
+    std::cout<<"przyspieszenie                  : "<<std::fixed<<serial.avgTimePerTest / parallel.avgTimePerTest
+             <<std::endl;
+}
+
 void sqrtTestCombo()
 {
     //Generate population.
@@ -194,6 +394,22 @@ void addTestCombo()
     addUnitTest(200,48);
     addUnitTest(200,56);
     addUnitTest(200,64);
+
+    //Whole arrays of numbers, one number per vector lane.
+    int batchSize = 1024;
+    int batchRepeats = 20;
+    std::vector<float> firstFloats = Test::generateRandomFloats(batchSize, 0xfffffff,0,1000);
+    std::vector<float> secondFloats = Test::generateRandomFloats(batchSize, 0xfffffff,0,1000);
+
+    std::cerr<<"Wsadowo - zmienna mantysa staly wykladnik"<<std::endl;
+
+    addBatchUnitTest(52,11);
+    addBatchUnitTest(200,8);
+    addBatchUnitTest(490,8);
+    addBatchUnitTest(1000,8);
+    addBatchUnitTest(2000,8);
+    addBatchUnitTest(4000,8);
+    addBatchUnitTest(200,64);
 }
 
 void subTestCombo()
@@ -266,6 +482,22 @@ void subTestCombo()
     subUnitTest(200,48);
     subUnitTest(200,56);
     subUnitTest(200,64);
+
+    //Whole arrays of numbers, one number per vector lane.
+    int batchSize = 1024;
+    int batchRepeats = 20;
+    std::vector<float> firstFloats = Test::generateRandomFloats(batchSize, 0xfffffff,0,1000);
+    std::vector<float> secondFloats = Test::generateRandomFloats(batchSize, 0xfffffff,0,1000);
+
+    std::cerr<<"Wsadowo - zmienna mantysa staly wykladnik"<<std::endl;
+
+    subBatchUnitTest(52,11);
+    subBatchUnitTest(200,8);
+    subBatchUnitTest(490,8);
+    subBatchUnitTest(1000,8);
+    subBatchUnitTest(2000,8);
+    subBatchUnitTest(4000,8);
+    subBatchUnitTest(200,64);
 }
 
 void mulTestCombo()
@@ -412,6 +644,167 @@ void divTestCombo()
     divUnitTest(200,64);
 }
 
+void mulKernelTestCombo()
+{
+    //Generate population.
+    int populationSize = 4;
+    std::vector<float> randomFloats = Test::generateRandomFloats(populationSize, 0xfffffff,0,1000);
+
+    //Default thresholds are restored after each size.
+    const u_int karatsubaThreshold = LimbArray::karatsubaThreshold;
+    const u_int transformThreshold = LimbArray::transformThreshold;
+
+    std::cerr<<"Mnozenie - porownanie algorytmow"<<std::endl;
+
+    mulKernelUnitTest(1000,32);
+    mulKernelUnitTest(2000,32);
+    mulKernelUnitTest(4000,32);
+    mulKernelUnitTest(8000,32);
+    mulKernelUnitTest(16000,32);
+    mulKernelUnitTest(32000,32);
+    mulKernelUnitTest(64000,32);
+    mulKernelUnitTest(128000,32);
+    mulKernelUnitTest(256000,32);
+    mulKernelUnitTest(512000,32);
+    mulKernelUnitTest(1024000,32);
+}
+
+void carryKernelTestCombo()
+{
+    //Generate population.
+    int populationSize = 40;
+    std::vector<float> randomFloats = Test::generateRandomFloats(populationSize, 0xfffffff,0,1000);
+
+    const LimbArray::Kernel detectedKernel = LimbArray::detectKernel();
+
+    std::cerr<<"Dodawanie i mnozenie - jadra przeniesien"<<std::endl;
+
+    carryKernelUnitTest(200,8);
+    carryKernelUnitTest(490,8);
+    carryKernelUnitTest(1000,32);
+    carryKernelUnitTest(2000,32);
+    carryKernelUnitTest(4000,32);
+    carryKernelUnitTest(8000,32);
+}
+
+void parallelTestCombo()
+{
+    //Generate population.
+    int batchSize = 4096;
+    int parallelRepeats = 5;
+    std::vector<float> firstFloats = Test::generateRandomFloats(batchSize, 0xfffffff,0,1000);
+    std::vector<float> secondFloats = Test::generateRandomFloats(batchSize, 0xfffffff,1,1000);
+
+    std::cerr<<"Rownolegle przetwarzanie wsadowe"<<std::endl;
+
+    parallelUnitTest(52,11);
+    parallelUnitTest(200,8);
+    parallelUnitTest(1000,32);
+    parallelUnitTest(4000,32);
+}
+
+void scalingTestCombo()
+{
+    //Generate population.
+    int populationSize = 4;
+    std::vector<float> randomFloats = Test::generateRandomFloats(populationSize, 0xfffffff,1,1000);
+
+    //Thread count doubles up to the size of the global pool.
+    const u_int maxThreads = ThreadPool::global().getThreadCount();
+
+    std::cerr<<"Mnozenie i dzielenie - skalowanie z liczba watkow"<<std::endl;
+
+    scalingUnitTest(100000,32);
+    scalingUnitTest(250000,32);
+    scalingUnitTest(1000000,32);
+}
+
+void outParamTestCombo()
+{
+    //Generate population.
+    int populationSize = 40;
+    std::vector<float> randomFloats = Test::generateRandomFloats(populationSize, 0xfffffff,0,1000);
+
+    std::cerr<<"Operatory a API z parametrem wyjsciowym"<<std::endl;
+
+    outParamUnitTest(20,8);
+    outParamUnitTest(60,8);
+    outParamUnitTest(100,8);
+    outParamUnitTest(200,8);
+    outParamUnitTest(300,8);
+    outParamUnitTest(400,8);
+    outParamUnitTest(490,8);
+    outParamUnitTest(200,64);
+}
+
+void fmaTestCombo()
+{
+    //Generate population.
+    int populationSize = 40;
+    std::vector<float> randomFloats = Test::generateRandomFloats(populationSize, 0xfffffff,0,1000);
+
+    std::cerr<<"Mnozenie z dodawaniem - pojedyncze zaokraglenie"<<std::endl;
+
+    fmaUnitTest(23,8);
+    fmaUnitTest(52,11);
+    fmaUnitTest(100,8);
+    fmaUnitTest(200,8);
+    fmaUnitTest(490,8);
+    fmaUnitTest(1000,32);
+    fmaUnitTest(4000,32);
+}
+
+void sumTestCombo()
+{
+    //Generate population.
+    int sumSize = 10000;
+    int sumRepeats = 10;
+    std::vector<float> randomFloats = Test::generateRandomFloats(sumSize, 0xfffffff,0,1000);
+
+    std::cerr<<"Sumowanie - dodawanie a akumulatory"<<std::endl;
+
+    sumUnitTest(23,8);
+    sumUnitTest(52,11);
+    sumUnitTest(200,16);
+    sumUnitTest(1000,32);
+}
+
+void expressionTestCombo()
+{
+    //Generate population.
+    int populationSize = 40;
+    std::vector<float> randomFloats = Test::generateRandomFloats(populationSize, 0xfffffff,0,1000);
+
+    std::cerr<<"Szablony wyrazen - jedno zaokraglenie"<<std::endl;
+
+    expressionUnitTest(23,8);
+    expressionUnitTest(52,11);
+    expressionUnitTest(100,8);
+    expressionUnitTest(200,8);
+    expressionUnitTest(490,8);
+    expressionUnitTest(1000,32);
+    expressionUnitTest(200,64);
+}
+
+void multiDoubleTestCombo()
+{
+    //Generate population.
+    int populationSize = 1000;
+    int multiDoubleRepeats = 10;
+    std::vector<float> firstFloats = Test::generateRandomFloats(populationSize, 0xfffffff,0,1000);
+    std::vector<float> secondFloats = Test::generateRandomFloats(populationSize, 0xfffffff,0,1000);
+    static const char *const operationNames[] = {"Dodawanie", "Mnozenie", "Dzielenie", "Pierwiastek"};
+
+    std::cerr<<"Double-double i quad-double a arytmetyka limbow"<<std::endl;
+
+    multiDoubleUnitTest(60,11);
+    multiDoubleUnitTest(100,11);
+    multiDoubleUnitTest(104,15);
+    multiDoubleUnitTest(150,11);
+    multiDoubleUnitTest(200,11);
+    multiDoubleUnitTest(208,15);
+}
+
 int main()
 {
     srand(time(nullptr));
@@ -420,6 +813,15 @@ int main()
     mulTestCombo();
     divTestCombo();
     sqrtTestCombo();
+    outParamTestCombo();
+    mulKernelTestCombo();
+    carryKernelTestCombo();
+    parallelTestCombo();
+    scalingTestCombo();
+    fmaTestCombo();
+    sumTestCombo();
+    expressionTestCombo();
+    multiDoubleTestCombo();
     return 0;
 }
 
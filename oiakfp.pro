@@ -1,23 +1,57 @@
 TEMPLATE = app
-CONFIG += console c++11
+CONFIG += console c++11 thread
 CONFIG -= app_bundle
 CONFIG -= qt
 
+# Thread count of the global thread pool (0 - hardware concurrency).
+isEmpty(OIAKFP_THREADS): OIAKFP_THREADS = 0
+DEFINES += OIAKFP_THREADS=$$OIAKFP_THREADS
+
+# Native integer arithmetic of formats with up to 123 fraction bits (0 - limb arithmetic only).
+isEmpty(OIAKFP_NATIVE): OIAKFP_NATIVE = 1
+DEFINES += OIAKFP_NATIVE=$$OIAKFP_NATIVE
+
+# Double-double and quad-double arithmetic of formats with up to 208 fraction bits and 62 exponent bits
+# that have no native arithmetic (correct rounding not guaranteed).
+isEmpty(OIAKFP_MULTIDOUBLE): OIAKFP_MULTIDOUBLE = 0
+DEFINES += OIAKFP_MULTIDOUBLE=$$OIAKFP_MULTIDOUBLE
+
 HEADERS += \
     VariableFloat.h \
+    NativeArithmetic.h \
+    MultiDouble.h \
+    WorkingExponent.h \
+    VariableFloatArray.h \
     util/Timer.h \
     ByteArray.h \
+    LimbArray.h \
+    LimbPlanes.h \
+    ScratchArena.h \
+    ThreadPool.h \
+    ParallelBatch.h \
+    KulischAccumulator.h \
+    DeferredAccumulator.h \
+    VariableFloatExpression.h \
     test/Test.h \
     test/SubTest.h \
     test/MulTest.h \
     test/AddTest.h \
     test/DivTest.h \
-    test/SqrtTest.h
+    test/SqrtTest.h \
+    test/ParallelTest.h \
+    test/FmaTest.h \
+    test/SumTest.h \
+    test/ExpressionTest.h \
+    test/MultiDoubleTest.h
 
 SOURCES += \
     main.cpp \
     util/Timer.cpp \
     ByteArray.cpp \
+    LimbArray.cpp \
+    LimbPlanes.cpp \
+    ScratchArena.cpp \
+    ThreadPool.cpp \
     test/Test.cpp \
     test/SubTest.cpp \
     test/MulTest.cpp \
@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <gmpxx.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../DeferredAccumulator.h"
+#include "../KulischAccumulator.h"
+#include "../MultiDouble.h"
+#include "../VariableFloat.h"
+#include "../VariableFloatExpression.h"
+
+//Accuracy checks against exact rational arithmetic (GMP), the program returns the number of failed checks.
+
+/// Converts a finite number to an exact rational value.
+template<int fraction, int exponent>
+mpq_class exact(const VariableFloat<fraction, exponent> &value)
+{
+    typedef VariableFloat<fraction, exponent> Float;
+    if (value.isZero()) return 0;
+
+    mpz_class significand;
+    mpz_import(significand.get_mpz_t(), Float::fractionLimbs, -1, sizeof(u_int64_t), 0, 0,
+               value.getFractionContainer().data());
+    mpq_class result(significand);
+    long long shift = (long long) value.getExponentContainer()[0] - ((1LL << (exponent - 1)) - 1) -
+                      (64 * (long long) Float::fractionLimbs - 1);
+    if (shift >= 0) mpq_mul_2exp(result.get_mpq_t(), result.get_mpq_t(), (mp_bitcnt_t) shift);
+    else mpq_div_2exp(result.get_mpq_t(), result.get_mpq_t(), (mp_bitcnt_t) -shift);
+    return value.getSign() ? mpq_class(-result) : result;
+}
+
+/// Rounds an exact rational value to nearest, ties to even (the value must lie in the normal range).
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> rounded(const mpq_class &value)
+{
+    typedef VariableFloat<fraction, exponent> Float;
+    Float result;
+    if (value == 0) return result;
+
+    //Magnitude is scaled to [2^fraction, 2^(fraction + 1)) and rounded to an integer.
+    mpq_class magnitude = abs(value);
+    long long power = (long long) mpz_sizeinbase(magnitude.get_num_mpz_t(), 2) -
+                      (long long) mpz_sizeinbase(magnitude.get_den_mpz_t(), 2);
+    mpq_class scaled = magnitude;
+    long long shift = fraction - power;
+    if (shift >= 0) mpq_mul_2exp(scaled.get_mpq_t(), scaled.get_mpq_t(), (mp_bitcnt_t) shift);
+    else mpq_div_2exp(scaled.get_mpq_t(), scaled.get_mpq_t(), (mp_bitcnt_t) -shift);
+    mpz_class lowest = mpz_class(1) << fraction;
+    if (scaled < lowest)
+    {
+        scaled *= 2;
+        --power;
+    }
+
+    mpz_class integer = scaled.get_num() / scaled.get_den();
+    mpq_class remainder = scaled - integer;
+    if (remainder > mpq_class(1, 2) || (remainder == mpq_class(1, 2) && mpz_odd_p(integer.get_mpz_t()))) ++integer;
+    if (integer == 2 * lowest)
+    {
+        integer = lowest;
+        ++power;
+    }
+
+    //Exactly representable significand is only normalized by 'setResult'.
+    std::vector<u_int64_t> limbs(Float::fractionLimbs, 0);
+    integer <<= 64 * Float::fractionLimbs - 1 - fraction;
+    mpz_export(limbs.data(), nullptr, -1, sizeof(u_int64_t), 0, 0, integer.get_mpz_t());
+    typename Float::ExponentWork resultExponent = Float::loadExponent(Float::getBias());
+    Float::adjustExponent(resultExponent, power);
+    result.setResult(value < 0, resultExponent, limbs.data(), Float::fractionLimbs);
+    return result;
+}
+
+/// Creates a random number with a given unbiased exponent, its significand is all ones in every fourth case.
+template<int fraction, int exponent>
+VariableFloat<fraction, exponent> randomNumber(std::mt19937_64 &generator, long long power)
+{
+    mpz_class significand = 1;
+    bool ones = generator() % 4 == 0;
+    for (int i = 0; i < fraction; ++i) significand = 2 * significand + (ones ? 1 : (int) (generator() & 1));
+    mpq_class value(significand);
+    if (power - fraction >= 0) mpq_mul_2exp(value.get_mpq_t(), value.get_mpq_t(), (mp_bitcnt_t) (power - fraction));
+    else mpq_div_2exp(value.get_mpq_t(), value.get_mpq_t(), (mp_bitcnt_t) (fraction - power));
+    return rounded<fraction, exponent>(generator() % 2 ? mpq_class(-value) : value);
+}
+
+/// Compares a result with the exact value rounded once.
+template<int fraction, int exponent>
+bool expect(const std::string &name, const VariableFloat<fraction, exponent> &result, const mpq_class &value)
+{
+    VariableFloat<fraction, exponent> reference = rounded<fraction, exponent>(value);
+    if (exact(result) == exact(reference)) return true;
+    std::cout<<"blad "<<name<<" <"<<fraction<<", "<<exponent<<">: "<<exact(result).get_d()
+             <<" zamiast "<<exact(reference).get_d()<<std::endl;
+    return false;
+}
+
+/// Sums random numbers and products in several accumulators and merges them in a random tree.
+template<int fraction, int exponent>
+int checkKulischMerge(std::mt19937_64 &generator, long long range)
+{
+    typedef VariableFloat<fraction, exponent> Float;
+    typedef KulischAccumulator<fraction, exponent> Accumulator;
+    int failed = 0;
+
+    //Carry of the second merge reaches the highest limb of the merged register.
+    if (exponent >= 20)
+    {
+        mpq_class x = (mpz_class(1) << 53) - 1;
+        mpq_mul_2exp(x.get_mpq_t(), x.get_mpq_t(), 74);
+        Float value = rounded<fraction, exponent>(x);
+        Accumulator a, b, c;
+        a += value;
+        b += value;
+        b += value;
+        a.merge(b);
+        c.merge(a);
+        failed += !expect("scalanie przeniesienia", c.result(), 3 * exact(value));
+    }
+
+    for (int trial = 0; trial < 300; ++trial)
+    {
+        std::vector<Accumulator> parts(1 + generator() % 8);
+        mpq_class sum = 0;
+        const long long base = (long long) (generator() % (2 * range + 1)) - range;
+        for (int i = 0, count = 1 + (int) (generator() % 32); i < count; ++i)
+        {
+            //Half of the summands share an exponent, so that carries run into the highest limbs.
+            Accumulator &part = parts[generator() % parts.size()];
+            long long power = generator() % 2 ? base : (long long) (generator() % (2 * range + 1)) - range;
+            Float first = randomNumber<fraction, exponent>(generator, power);
+            if (generator() % 4 == 0)
+            {
+                Float second = randomNumber<fraction, exponent>(generator, (long long) (generator() % 16) - 8);
+                part.addProduct(first, second);
+                sum += exact(first) * exact(second);
+            }
+            else if (generator() % 2)
+            {
+                part -= first;
+                sum -= exact(first);
+            }
+            else
+            {
+                part += first;
+                sum += exact(first);
+            }
+        }
+
+        while (parts.size() > 1)
+        {
+            std::size_t target = generator() % parts.size();
+            std::size_t source = (target + 1 + generator() % (parts.size() - 1)) % parts.size();
+            parts[target].merge(parts[source]);
+            parts.erase(parts.begin() + source);
+        }
+        Accumulator total;
+        total.merge(parts[0]);
+        failed += !expect("scalanie drzewa", total.result(), sum);
+    }
+    return failed;
+}
+
+/// Returns the unit in the last place of a non-zero rational value.
+template<int fraction>
+mpq_class ulp(const mpq_class &value)
+{
+    mpq_class magnitude = abs(value);
+    long long power = (long long) mpz_sizeinbase(magnitude.get_num_mpz_t(), 2) -
+                      (long long) mpz_sizeinbase(magnitude.get_den_mpz_t(), 2);
+    mpq_class bound = 1;
+    if (power >= 0) mpq_mul_2exp(bound.get_mpq_t(), bound.get_mpq_t(), (mp_bitcnt_t) power);
+    else mpq_div_2exp(bound.get_mpq_t(), bound.get_mpq_t(), (mp_bitcnt_t) -power);
+    if (magnitude < bound) bound /= 2;
+    mpq_div_2exp(bound.get_mpq_t(), bound.get_mpq_t(), fraction);
+    return bound;
+}
+
+/// Checks sums of DeferredAccumulator: cancellation, sums of positive numbers (rounded once) and the error bound
+/// of mixed sums, half an ulp plus the dropped parts (each below 2^-64 ulp of the running sum or the summand).
+template<int fraction, int exponent>
+int checkDeferred(std::mt19937_64 &generator, long long range)
+{
+    typedef VariableFloat<fraction, exponent> Float;
+    typedef DeferredAccumulator<fraction, exponent> Accumulator;
+    int failed = 0;
+
+    //Small summand dropped below a large one must not survive its cancellation, as with repeated operator+.
+    {
+        Float large = randomNumber<fraction, exponent>(generator, range / 3);
+        Float small = randomNumber<fraction, exponent>(generator, -range / 3);
+        Float negated = large;
+        negated.setSign(!large.getSign());
+        Accumulator sum;
+        sum += large;
+        sum += small;
+        sum += negated;
+        failed += !expect("odejmowanie po pominieciu", sum.result(), 0);
+        failed += !expect("odejmowanie po pominieciu", large + small + negated, 0);
+    }
+
+    for (int trial = 0; trial < 300; ++trial)
+    {
+        const bool positive = trial % 2 == 0;
+        Accumulator sum;
+        mpq_class value = 0;
+        mpq_class dropped = 0;
+        for (int i = 0, count = 1 + (int) (generator() % 64); i < count; ++i)
+        {
+            Float summand = randomNumber<fraction, exponent>(generator,
+                                                            (long long) (generator() % (2 * range + 1)) - range);
+            if (positive) summand.setSign(false);
+            mpq_class previous = value;
+            if (!positive && generator() % 2)
+            {
+                sum -= summand;
+                value -= exact(summand);
+            }
+            else
+            {
+                sum += summand;
+                value += exact(summand);
+            }
+            mpq_class larger = std::max(abs(previous), abs(exact(summand)));
+            mpq_class part = ulp<fraction>(larger);
+            mpq_div_2exp(part.get_mpq_t(), part.get_mpq_t(), 63);
+            dropped += part;
+        }
+
+        Float result = sum.result();
+        if (positive)
+        {
+            failed += !expect("suma dodatnia", result, value);
+            continue;
+        }
+        mpq_class bound = dropped + (value == 0 ? mpq_class(0) : mpq_class(ulp<fraction>(value) / 2));
+        if (abs(exact(result) - value) > bound)
+        {
+            std::cout<<"blad ograniczenia sumy <"<<fraction<<", "<<exponent<<">"<<std::endl;
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+/// Checks sums of two products evaluated as expressions, which have to be rounded once.
+template<int fraction, int exponent>
+int checkExpression(std::mt19937_64 &generator, long long range)
+{
+    typedef VariableFloat<fraction, exponent> Float;
+    int failed = 0;
+    for (int trial = 0; trial < 300; ++trial)
+    {
+        //a * b - a * (b + ulp) leaves only the lowest order bits of exact products, half of the cases cancel so.
+        Float a = randomNumber<fraction, exponent>(generator, (long long) (generator() % (2 * range + 1)) - range);
+        Float b = randomNumber<fraction, exponent>(generator, (long long) (generator() % (2 * range + 1)) - range);
+        Float c = a;
+        Float d = rounded<fraction, exponent>(exact(b) + ulp<fraction>(exact(b)));
+        if (trial % 2)
+        {
+            c = randomNumber<fraction, exponent>(generator, (long long) (generator() % (2 * range + 1)) - range);
+            d = randomNumber<fraction, exponent>(generator, (long long) (generator() % (2 * range + 1)) - range);
+        }
+        Float difference = vf::lazy(a) * b - vf::lazy(c) * d;
+        Float sum = vf::lazy(a) * b + vf::lazy(c) * d;
+        failed += !expect("roznica iloczynow", difference, exact(a) * exact(b) - exact(c) * exact(d));
+        failed += !expect("suma iloczynow", sum, exact(a) * exact(b) + exact(c) * exact(d));
+    }
+    return failed;
+}
+
+/// Measures errors of MultiDoubleArithmetic operations (called directly, whatever OIAKFP_MULTIDOUBLE is) against
+/// exact results and checks the documented accuracy: every result correctly rounded.
+template<int fraction, int exponent>
+int checkMultiDouble(std::mt19937_64 &generator, int count)
+{
+    typedef VariableFloat<fraction, exponent> Float;
+    typedef MultiDoubleArithmetic<fraction, exponent> Arithmetic;
+    static const char *const names[] = {"dodawanie", "odejmowanie", "mnozenie", "dzielenie", "pierwiastek"};
+    const mp_bitcnt_t precision = 4 * fraction + 256;
+    int failed = 0;
+
+    for (int operation = 0; operation < 5; ++operation)
+    {
+        double worst = 0;
+        int correct = 0;
+        for (int trial = 0; trial < count; ++trial)
+        {
+            //Half of the operands have close exponents, so that sums cancel.
+            const long long range = trial % 2 ? 300 : 2;
+            Float a = randomNumber<fraction, exponent>(generator, (long long) (generator() % (2 * range + 1)) - range);
+            Float b = randomNumber<fraction, exponent>(generator, (long long) (generator() % (2 * range + 1)) - range);
+            Float result;
+            mpf_class value(0, precision);
+            switch (operation)
+            {
+                case 0:
+                    Arithmetic::add(result, a, b);
+                    value = mpf_class(exact(a) + exact(b), precision);
+                    break;
+                case 1:
+                    b.setSign(!b.getSign());
+                    Arithmetic::add(result, a, b);
+                    value = mpf_class(exact(a) + exact(b), precision);
+                    break;
+                case 2:
+                    Arithmetic::multiply(result, a, b);
+                    value = mpf_class(exact(a) * exact(b), precision);
+                    break;
+                case 3:
+                    Arithmetic::divide(result, a, b);
+                    value = mpf_class(exact(a) / exact(b), precision);
+                    break;
+                default:
+                    a.setSign(false);
+                    Arithmetic::sqrt(result, a);
+                    value = sqrt(mpf_class(exact(a), precision));
+            }
+
+            //Sums that cancel exactly are correctly rounded zeros.
+            if (value == 0)
+            {
+                correct += result.isZero();
+                worst = result.isZero() ? worst : 1e9;
+                continue;
+            }
+            mpq_class reference(value);
+            mpf_class error(abs(mpf_class(exact(result), precision) - value), precision);
+            error /= mpf_class(ulp<fraction>(reference), precision);
+            worst = std::max(worst, error.get_d());
+            correct += exact(result) == exact(rounded<fraction, exponent>(reference));
+        }
+
+        if (worst > 0.5 || correct != count)
+        {
+            std::cout<<"blad dokladnosci MultiDouble "<<names[operation]<<" <"<<fraction<<", "<<exponent<<">: "
+                     <<worst<<" ulp, poprawnie zaokraglonych "<<correct<<" z "<<count<<std::endl;
+            ++failed;
+        }
+    }
+    return failed;
+}
+
+int main()
+{
+    std::mt19937_64 generator(2024);
+    int failed = 0;
+    failed += checkKulischMerge<52, 11>(generator, 900);
+    failed += checkKulischMerge<52, 20>(generator, 2000);
+    failed += checkKulischMerge<200, 24>(generator, 2000);
+    failed += checkDeferred<52, 11>(generator, 900);
+    failed += checkDeferred<200, 15>(generator, 900);
+    failed += checkDeferred<490, 15>(generator, 900);
+    failed += checkExpression<52, 11>(generator, 200);
+    failed += checkExpression<200, 15>(generator, 200);
+    failed += checkExpression<490, 15>(generator, 200);
+    failed += checkMultiDouble<59, 11>(generator, 2000);
+    failed += checkMultiDouble<100, 11>(generator, 2000);
+    failed += checkMultiDouble<101, 11>(generator, 2000);
+    failed += checkMultiDouble<104, 11>(generator, 2000);
+    failed += checkMultiDouble<104, 20>(generator, 2000);
+    failed += checkMultiDouble<105, 11>(generator, 2000);
+    failed += checkMultiDouble<150, 15>(generator, 2000);
+    failed += checkMultiDouble<208, 11>(generator, 2000);
+    std::cout<<"nieudane sprawdzenia             : "<<failed<<std::endl;
+    return failed != 0;
+}
@@ -3,6 +3,7 @@
 #include "Test.h"
 #include <vector>
 #include "../VariableFloat.h"
+#include "../VariableFloatArray.h"
 
 template<int fraction, int exponent>
 class AddTest : public UnitTimeTest
@@ -32,3 +33,41 @@ public:
         testNb++;
     }
 };
+
+/// Variant of AddTest using the output parameter API (vf::add), result storage is reused between tests.
+template<int fraction, int exponent>
+class AddOutTest : public AddTest<fraction, exponent>
+{
+protected:
+    VariableFloat<fraction, exponent> result;
+
+public:
+    explicit AddOutTest(VariableFloat<fraction, exponent> *d) : AddTest<fraction, exponent>(d) {}
+
+    void runTest() override
+    {
+        vf::add(result, *this->currentA, *this->currentB);
+    }
+};
+
+/// Batch variant of AddTest, every test processes whole arrays with vf::add on VariableFloatArray.
+/// With 'elementwise' set the arrays are processed element by element with VariableFloat::add instead.
+template<int fraction, int exponent>
+class AddBatchTest : public UnitTimeTest
+{
+protected:
+    const VariableFloatArray<fraction, exponent> &first;
+    const VariableFloatArray<fraction, exponent> &second;
+    VariableFloatArray<fraction, exponent> result;
+    bool elementwise;
+
+public:
+    AddBatchTest(const VariableFloatArray<fraction, exponent> &a, const VariableFloatArray<fraction, exponent> &b,
+                 bool perElement) : first(a), second(b), result(a.size()), elementwise(perElement) {}
+
+    void runTest() override
+    {
+        if (elementwise) vf::apply(result, first, second, VariableFloat<fraction, exponent>::add);
+        else vf::add(result, first, second);
+    }
+};
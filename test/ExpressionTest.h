@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Test.h"
+#include "../VariableFloat.h"
+#include "../VariableFloatExpression.h"
+
+/// Times a * b + c * d - e evaluated as an expression template (accumulated with deferred rounding, no temporaries),
+/// the operands c, d and e are taken from the next tests' operands.
+template<int fraction, int exponent>
+class ExpressionTest : public UnitTimeTest
+{
+protected:
+    int testNb;
+    int count;
+    VariableFloat<fraction, exponent>* data;
+    VariableFloat<fraction, exponent>* currentA;
+    VariableFloat<fraction, exponent>* currentB;
+    VariableFloat<fraction, exponent>* currentC;
+    VariableFloat<fraction, exponent>* currentD;
+    VariableFloat<fraction, exponent>* currentE;
+    VariableFloat<fraction, exponent> result;
+
+public:
+    ExpressionTest(VariableFloat<fraction, exponent> *d, int size) : testNb(0), count(size), data(d) {}
+
+    void runTest() override
+    {
+        vf::evaluate(result, vf::lazy(*currentA) * *currentB + vf::lazy(*currentC) * *currentD - *currentE);
+    }
+
+    void runBeforeTest() override
+    {
+        currentA = &(data[2*testNb]);
+        currentB = &(data[2*testNb+1]);
+        currentC = &(data[(2*testNb+2)%count]);
+        currentD = &(data[(2*testNb+3)%count]);
+        currentE = &(data[(2*testNb+4)%count]);
+    }
+
+    void runAfterTest() override
+    {
+        testNb++;
+    }
+};
+
+/// Variant of ExpressionTest computing the same expression with VariableFloat operators (every operation rounded).
+template<int fraction, int exponent>
+class OperatorExpressionTest : public ExpressionTest<fraction, exponent>
+{
+public:
+    OperatorExpressionTest(VariableFloat<fraction, exponent> *d, int size) : ExpressionTest<fraction, exponent>(d, size) {}
+
+    void runTest() override
+    {
+        this->result = *this->currentA * *this->currentB + *this->currentC * *this->currentD - *this->currentE;
+    }
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Test.h"
+#include <vector>
+#include "../VariableFloat.h"
+
+/// Times fused multiply-add a * b + c rounded once, the addend is taken from the next test's operands.
+template<int fraction, int exponent>
+class FmaTest : public UnitTimeTest
+{
+protected:
+    int testNb;
+    int count;
+    VariableFloat<fraction, exponent>* data;
+    VariableFloat<fraction, exponent>* currentA;
+    VariableFloat<fraction, exponent>* currentB;
+    VariableFloat<fraction, exponent>* currentC;
+    VariableFloat<fraction, exponent> result;
+
+public:
+    FmaTest(VariableFloat<fraction, exponent> *d, int size) : testNb(0), count(size), data(d) {}
+
+    void runTest() override
+    {
+        vf::fma(result, *currentA, *currentB, *currentC);
+    }
+
+    void runBeforeTest() override
+    {
+        currentA = &(data[2*testNb]);
+        currentB = &(data[2*testNb+1]);
+        currentC = &(data[(2*testNb+2)%count]);
+    }
+
+    void runAfterTest() override
+    {
+        testNb++;
+    }
+};
+
+/// Variant of FmaTest computing the same value with a separately rounded multiplication and addition.
+template<int fraction, int exponent>
+class MulAddTest : public FmaTest<fraction, exponent>
+{
+protected:
+    VariableFloat<fraction, exponent> product;
+
+public:
+    MulAddTest(VariableFloat<fraction, exponent> *d, int size) : FmaTest<fraction, exponent>(d, size) {}
+
+    void runTest() override
+    {
+        vf::mul(product, *this->currentA, *this->currentB);
+        vf::add(this->result, product, *this->currentC);
+    }
+};
@@ -31,4 +31,20 @@ public:
     {
         testNb++;
     }
-};
\ No newline at end of file
+};
+
+/// Variant of MulTest using the output parameter API (vf::mul), result storage is reused between tests.
+template<int fraction, int exponent>
+class MulOutTest : public MulTest<fraction, exponent>
+{
+protected:
+    VariableFloat<fraction, exponent> result;
+
+public:
+    explicit MulOutTest(VariableFloat<fraction, exponent> *d) : MulTest<fraction, exponent>(d) {}
+
+    void runTest() override
+    {
+        vf::mul(result, *this->currentA, *this->currentB);
+    }
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Test.h"
+#include <vector>
+#include "../MultiDouble.h"
+#include "../ParallelBatch.h"
+#include "../VariableFloat.h"
+
+/// Methods of computing an operation compared by MultiDoubleTest.
+enum class MultiDoubleMethod
+{
+    VariableFloat,
+    Converted,
+    Kept
+};
+
+/// Applies an operation to all operand pairs in every test: with VariableFloat arithmetic (limb or native),
+/// with MultiDoubleArithmetic (conversion to double-double or quad-double and back in every operation)
+/// or on MultiDouble numbers converted once.
+template<int fraction, int exponent>
+class MultiDoubleTest : public UnitTimeTest
+{
+protected:
+    typedef MultiDoubleArithmetic<fraction, exponent> Arithmetic;
+    typedef typename Arithmetic::Number Number;
+
+    std::vector<VariableFloat<fraction, exponent>> first;
+    std::vector<VariableFloat<fraction, exponent>> second;
+    std::vector<Number> firstNumbers;
+    std::vector<Number> secondNumbers;
+    VariableFloat<fraction, exponent> result;
+    Number numberResult;
+    BatchCost operation;
+    MultiDoubleMethod method;
+
+public:
+    MultiDoubleTest(const std::vector<float> &a, const std::vector<float> &b, BatchCost op, MultiDoubleMethod m)
+            : operation(op), method(m)
+    {
+        for (std::size_t i = 0; i < a.size() && i < b.size(); ++i)
+        {
+            first.emplace_back(a[i]);
+            second.emplace_back(b[i]);
+            firstNumbers.emplace_back(first.back());
+            secondNumbers.emplace_back(second.back());
+        }
+    }
+
+    void runTest() override
+    {
+        if (method == MultiDoubleMethod::Kept) runKept();
+        else if (method == MultiDoubleMethod::Converted) runConverted();
+        else runVariableFloat();
+    }
+
+private:
+    void runVariableFloat()
+    {
+        typedef VariableFloat<fraction, exponent> Float;
+        for (std::size_t i = 0; i < first.size(); ++i)
+        {
+            switch (operation)
+            {
+                case BatchCost::Add:
+                    Float::add(result, first[i], second[i]);
+                    break;
+                case BatchCost::Multiply:
+                    Float::multiply(result, first[i], second[i]);
+                    break;
+                case BatchCost::Divide:
+                    Float::divide(result, first[i], second[i]);
+                    break;
+                default:
+                    Float::sqrt(result, first[i]);
+            }
+        }
+    }
+
+    void runConverted()
+    {
+        for (std::size_t i = 0; i < first.size(); ++i)
+        {
+            switch (operation)
+            {
+                case BatchCost::Add:
+                    Arithmetic::add(result, first[i], second[i]);
+                    break;
+                case BatchCost::Multiply:
+                    Arithmetic::multiply(result, first[i], second[i]);
+                    break;
+                case BatchCost::Divide:
+                    Arithmetic::divide(result, first[i], second[i]);
+                    break;
+                default:
+                    Arithmetic::sqrt(result, first[i]);
+            }
+        }
+    }
+
+    void runKept()
+    {
+        for (std::size_t i = 0; i < firstNumbers.size(); ++i)
+        {
+            switch (operation)
+            {
+                case BatchCost::Add:
+                    Number::add(numberResult, firstNumbers[i], secondNumbers[i]);
+                    break;
+                case BatchCost::Multiply:
+                    Number::multiply(numberResult, firstNumbers[i], secondNumbers[i]);
+                    break;
+                case BatchCost::Divide:
+                    Number::divide(numberResult, firstNumbers[i], secondNumbers[i]);
+                    break;
+                default:
+                    Number::sqrt(numberResult, firstNumbers[i]);
+            }
+        }
+    }
+};
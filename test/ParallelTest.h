@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Test.h"
+#include <vector>
+#include "../VariableFloat.h"
+#include "../ParallelBatch.h"
+
+/// Every test processes whole operand vectors with a vf::parallel operation on a given pool.
+template<int fraction, int exponent>
+class ParallelTest : public UnitTimeTest
+{
+protected:
+    std::vector<VariableFloat<fraction, exponent>> first;
+    std::vector<VariableFloat<fraction, exponent>> second;
+    std::vector<VariableFloat<fraction, exponent>> result;
+    BatchCost operation;
+    ThreadPool *pool;
+
+public:
+    ParallelTest(const std::vector<float> &a, const std::vector<float> &b, BatchCost op)
+            : result(a.size()), operation(op), pool(&ThreadPool::global())
+    {
+        for (std::size_t i = 0; i < a.size() && i < b.size(); ++i)
+        {
+            first.emplace_back(a[i]);
+            second.emplace_back(b[i]);
+        }
+    }
+
+    void setPool(ThreadPool &threads) { pool = &threads; }
+
+    void runTest() override
+    {
+        VariableFloat<fraction, exponent> *out = result.data();
+        const VariableFloat<fraction, exponent> *a = first.data(), *b = second.data();
+        switch (operation)
+        {
+            case BatchCost::Add:
+                vf::parallel::add(out, a, b, first.size(), *pool);
+                break;
+            case BatchCost::Multiply:
+                vf::parallel::mul(out, a, b, first.size(), *pool);
+                break;
+            case BatchCost::Divide:
+                vf::parallel::div(out, a, b, first.size(), *pool);
+                break;
+            case BatchCost::SquareRoot:
+                vf::parallel::sqrt(out, a, first.size(), *pool);
+                break;
+            case BatchCost::Fma:
+                vf::parallel::fma(out, a, b, b, first.size(), *pool);
+                break;
+        }
+    }
+};
@@ -3,6 +3,7 @@
 #include "Test.h"
 #include <vector>
 #include "../VariableFloat.h"
+#include "../VariableFloatArray.h"
 
 template<int fraction, int exponent>
 class SubTest : public UnitTimeTest
@@ -32,3 +33,25 @@ public:
         testNb++;
     }
 };
+
+/// Batch variant of SubTest, every test processes whole arrays with vf::sub on VariableFloatArray.
+/// With 'elementwise' set the arrays are processed element by element with VariableFloat::subtract instead.
+template<int fraction, int exponent>
+class SubBatchTest : public UnitTimeTest
+{
+protected:
+    const VariableFloatArray<fraction, exponent> &first;
+    const VariableFloatArray<fraction, exponent> &second;
+    VariableFloatArray<fraction, exponent> result;
+    bool elementwise;
+
+public:
+    SubBatchTest(const VariableFloatArray<fraction, exponent> &a, const VariableFloatArray<fraction, exponent> &b,
+                 bool perElement) : first(a), second(b), result(a.size()), elementwise(perElement) {}
+
+    void runTest() override
+    {
+        if (elementwise) vf::apply(result, first, second, VariableFloat<fraction, exponent>::subtract);
+        else vf::sub(result, first, second);
+    }
+};
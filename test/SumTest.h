@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Test.h"
+#include "../DeferredAccumulator.h"
+#include "../KulischAccumulator.h"
+#include "../VariableFloat.h"
+
+/// Methods of summing an array compared by SumTest.
+enum class SumMethod
+{
+    Rounded,
+    Exact,
+    Deferred
+};
+
+/// Sums a whole array in every test, with repeated rounded addition, exactly with KulischAccumulator
+/// or with deferred normalization in DeferredAccumulator.
+template<int fraction, int exponent>
+class SumTest : public UnitTimeTest
+{
+protected:
+    const VariableFloat<fraction, exponent> *data;
+    int count;
+    SumMethod method;
+    VariableFloat<fraction, exponent> result;
+
+public:
+    SumTest(const VariableFloat<fraction, exponent> *d, int size, SumMethod sumMethod)
+        : data(d), count(size), method(sumMethod) {}
+
+    void runTest() override
+    {
+        if (method == SumMethod::Exact)
+        {
+            vf::sum(result, data, count);
+        }
+        else if (method == SumMethod::Deferred)
+        {
+            DeferredAccumulator<fraction, exponent> sum;
+            for (int i = 0; i < count; ++i) sum += data[i];
+            sum.result(result);
+        }
+        else
+        {
+            result = VariableFloat<fraction, exponent>();
+            for (int i = 0; i < count; ++i) result += data[i];
+        }
+    }
+};
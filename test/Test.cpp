@@ -1,5 +1,38 @@
 #include "Test.h"
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<long long> allocationCount(0);
+}
+
+//Global allocator replacement counting calls, so that tests can report allocations made by arithmetic.
+//VariableFloatArray planes and ScratchArena chunks are taken from it as well.
+void *operator new(std::size_t size)
+{
+    ++allocationCount;
+    if (void *pointer = std::malloc(size == 0 ? 1 : size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+long long Test::getAllocationCount()
+{
+    return allocationCount;
+}
+
 Test::TestResult Test::createTest(UnitTimeTest &unitTest, int testCount)
 {
     TestResult ret{};
@@ -14,11 +47,13 @@ Test::TestResult Test::createTest(UnitTimeTest &unitTest, int testCount)
         unitTest.runBeforeTest();
 
         Timer tm;
+        long long allocations = getAllocationCount();
         tm.start();
 
         unitTest.runTest();
 
         tm.stop();
+        ret.allocations += getAllocationCount() - allocations;
         timeOfTests += tm.elapsed();
         unitTest.runAfterTest();
     }
@@ -2,6 +2,7 @@
 
 #include "../util/Timer.h"
 #include "../VariableFloat.h"
+#include "../VariableFloatArray.h"
 
 #include "stdio.h"
 
@@ -30,9 +31,10 @@ public:
         int testCount;
         int fraction;
         int exponent;
+        long long allocations;
 
         void toCsv(std::ostream& str){
-            str<<std::fixed<<fraction<<", "<<exponent<<", "<<fullTime<<","<<fullTimeOfTests<<","<<avgTimePerTest<<","<<testCount<<"\n";
+            str<<std::fixed<<fraction<<", "<<exponent<<", "<<fullTime<<","<<fullTimeOfTests<<","<<avgTimePerTest<<","<<testCount<<","<<allocations<<"\n";
         }
     };
 
@@ -40,6 +42,9 @@ public:
 
     TestResult createTest(UnitTimeTest& unitTest, int testCount);
 
+    /// Returns the number of global allocator calls made by the program so far.
+    static long long getAllocationCount();
+
     static std::vector<float> generateRandomFloats(int size, int max, int min, int point){
         std::vector<float> ret;
 
@@ -59,3 +64,10 @@ void fillArray(VariableFloat<fraction, exponent> array[], int size, const std::v
     for(int i=0;i<size && i<data.size();++i)
         array[i] = VariableFloat<fraction, exponent>(data[i]);
 }
+
+template<int fraction, int exponent>
+void fillArray(VariableFloatArray<fraction, exponent> &array, const std::vector<float> &data)
+{
+    for(std::size_t i=0;i<array.size() && i<data.size();++i)
+        array[i] = VariableFloat<fraction, exponent>(data[i]);
+}